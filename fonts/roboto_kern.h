@@ -0,0 +1,74 @@
+#pragma once
+
+#include "font.h"
+#include "font_pack.h"
+#include "roboto.h"
+
+// Approximate kerning for the roboto fonts.
+//
+// The generated font headers don't include Roboto's kerning, and the font
+// file isn't in this tree to extract it from. roboto_kern_approx_em is NOT
+// Roboto's kern/GPOS data: it is a hand-picked set of the pairs that look
+// worst without kerning, with round values by eye, in 1/1000 em (see
+// kern_table() in font_pack.h). To use the real kerning, replace it with
+// the font's pairs (converted to 1/1000 em, sorted by left then right),
+// e.g. dumped with fontTools from the same Roboto the headers were made
+// from. Until then, add pairs as needed, keeping the list sorted.
+//
+//   roboto_N_kern      the approximate kerning, scaled for size N
+//   roboto_N_kerned    roboto_N using roboto_N_kern
+//
+// Only the tables actually used end up in flash.
+
+// clang-format off
+inline constexpr KernPairEm roboto_kern_approx_em[] = {
+    {'A', 'T', -70}, {'A', 'V', -70}, {'A', 'W', -50}, {'A', 'Y', -80},
+    {'A', 'v', -30}, {'A', 'w', -25}, {'A', 'y', -30},
+    {'F', ',', -100}, {'F', '.', -100}, {'F', 'A', -50}, {'F', 'a', -40},
+    {'L', 'T', -90}, {'L', 'V', -80}, {'L', 'W', -60}, {'L', 'Y', -90},
+    {'L', 'y', -40},
+    {'P', ',', -110}, {'P', '.', -110}, {'P', 'A', -60},
+    {'T', ',', -80}, {'T', '.', -80}, {'T', 'A', -70}, {'T', 'a', -80},
+    {'T', 'c', -80}, {'T', 'e', -80}, {'T', 'o', -80}, {'T', 'r', -60},
+    {'T', 'u', -60}, {'T', 'y', -60},
+    {'V', ',', -80}, {'V', '.', -80}, {'V', 'A', -70}, {'V', 'a', -50},
+    {'V', 'e', -50}, {'V', 'o', -50},
+    {'W', ',', -60}, {'W', '.', -60}, {'W', 'A', -50}, {'W', 'a', -40},
+    {'W', 'e', -40}, {'W', 'o', -40},
+    {'Y', ',', -90}, {'Y', '.', -90}, {'Y', 'A', -80}, {'Y', 'a', -70},
+    {'Y', 'e', -70}, {'Y', 'o', -70},
+    {'r', ',', -50}, {'r', '.', -50},
+    {'v', ',', -50}, {'v', '.', -50},
+    {'w', ',', -40}, {'w', '.', -40},
+    {'y', ',', -50}, {'y', '.', -50},
+};
+// clang-format on
+
+inline constexpr int roboto_kern_approx_em_cnt =
+    sizeof(roboto_kern_approx_em) / sizeof(roboto_kern_approx_em[0]);
+
+// em in pixels for roboto_N (line height, y_adv = N, is 2400/2048 em)
+static constexpr int roboto_em(int n)
+{
+    return (n * 2048 + 1200) / 2400;
+}
+
+#define ROBOTO_KERN(Z)                                                       \
+    inline constexpr int roboto_##Z##_kern_len =                             \
+        kern_len(roboto_kern_approx_em, roboto_kern_approx_em_cnt,           \
+                 roboto_em(Z));                                              \
+    inline constexpr KernTable<roboto_##Z##_kern_len>                        \
+        roboto_##Z##_kern_table = kern_table<roboto_##Z##_kern_len>(         \
+            roboto_kern_approx_em, roboto_kern_approx_em_cnt, roboto_em(Z)); \
+    inline constexpr Kerning roboto_##Z##_kern{                              \
+        roboto_##Z##_kern_table.pairs, roboto_##Z##_kern_len};               \
+    inline constexpr Font roboto_##Z##_kerned =                              \
+        font_kern(roboto_##Z, roboto_##Z##_kern);
+
+// clang-format off
+ROBOTO_KERN(16) ROBOTO_KERN(18) ROBOTO_KERN(20) ROBOTO_KERN(22) ROBOTO_KERN(24)
+ROBOTO_KERN(26) ROBOTO_KERN(28) ROBOTO_KERN(30) ROBOTO_KERN(32) ROBOTO_KERN(34)
+ROBOTO_KERN(36) ROBOTO_KERN(38) ROBOTO_KERN(40) ROBOTO_KERN(44) ROBOTO_KERN(48)
+// clang-format on
+
+#undef ROBOTO_KERN
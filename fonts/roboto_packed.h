@@ -0,0 +1,60 @@
+#pragma once
+
+#include "font.h"
+#include "font_pack.h"
+#include "roboto.h"
+
+// Compact versions of the roboto fonts, converted at compile time from the
+// 8-bit tables in roboto_N.h (see font_pack.h):
+//
+//   roboto_N_4     4-bit coverage (GlyphFormat::Gray4)
+//   roboto_N_rle4  4-bit coverage, runs of empty pixels coded
+//                  (GlyphFormat::Rle4)
+//
+// Only the fonts actually used end up in flash.
+
+#define ROBOTO_PACK(Z, SUFFIX, FORMAT)                                      \
+    inline constexpr int roboto_##Z##_##SUFFIX##_len =                      \
+        font_pack_len(roboto_##Z, FORMAT);                                  \
+    inline constexpr FontData<roboto_##Z##_##SUFFIX##_len>                  \
+        roboto_##Z##_##SUFFIX##_data =                                      \
+            font_pack_data<roboto_##Z##_##SUFFIX##_len>(roboto_##Z, FORMAT); \
+    inline constexpr Font roboto_##Z##_##SUFFIX = font_pack(                \
+        roboto_##Z, roboto_##Z##_##SUFFIX##_data.data, FORMAT);
+
+#define ROBOTO_PACK_BOTH(Z)                  \
+    ROBOTO_PACK(Z, 4, GlyphFormat::Gray4)    \
+    ROBOTO_PACK(Z, rle4, GlyphFormat::Rle4)
+
+// clang-format off
+ROBOTO_PACK_BOTH(16) ROBOTO_PACK_BOTH(18) ROBOTO_PACK_BOTH(20)
+ROBOTO_PACK_BOTH(22) ROBOTO_PACK_BOTH(24) ROBOTO_PACK_BOTH(26)
+ROBOTO_PACK_BOTH(28) ROBOTO_PACK_BOTH(30) ROBOTO_PACK_BOTH(32)
+ROBOTO_PACK_BOTH(34) ROBOTO_PACK_BOTH(36) ROBOTO_PACK_BOTH(38)
+ROBOTO_PACK_BOTH(40) ROBOTO_PACK_BOTH(44) ROBOTO_PACK_BOTH(48)
+// clang-format on
+
+#undef ROBOTO_PACK_BOTH
+#undef ROBOTO_PACK
+
+
+// Number-only subsets of the larger sizes: "-./0123456789:" (see
+// font_range() in font_pack.h), run-length coded:
+//
+//   roboto_N_num   FontRange, '-' through ':'
+
+#define ROBOTO_NUM(Z)                                                     \
+    inline constexpr int roboto_##Z##_num_len =                           \
+        font_range_len(roboto_##Z, '-', ':', GlyphFormat::Rle4);          \
+    inline constexpr FontRangeData<'-', ':', roboto_##Z##_num_len>        \
+        roboto_##Z##_num_data =                                           \
+            font_range_data<'-', ':', roboto_##Z##_num_len>(              \
+                roboto_##Z, GlyphFormat::Rle4);                           \
+    inline constexpr FontRange roboto_##Z##_num =                         \
+        font_range(roboto_##Z, roboto_##Z##_num_data, GlyphFormat::Rle4);
+
+// clang-format off
+ROBOTO_NUM(36) ROBOTO_NUM(38) ROBOTO_NUM(40) ROBOTO_NUM(44) ROBOTO_NUM(48)
+// clang-format on
+
+#undef ROBOTO_NUM
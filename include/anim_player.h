@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "animation.h"
+#include "framebuffer.h"
+
+// Plays an Animation (see animation.h) at a frame rate, without waiting.
+//
+// poll() is called from the main loop, as often as it likes. When the next
+// frame is due, and the display has finished with the last one, it queues
+// the frame's fills and copies as async ops and returns; otherwise it
+// returns straight away. So the rest of the loop keeps running while the
+// frames go out.
+//
+// Frames must be shown in order (each is a change to the one before), so
+// when spi can't keep up, or poll() isn't called often enough, frames are
+// late rather than skipped, and the animation runs slower. Each frame time
+// that passes without a frame being shown is counted as dropped.
+//
+//   AnimPlayer spinner(fb, hor, ver, &spinner_anim.hdr, 15);
+//   spinner.start();
+//   while (connecting) {
+//       spinner.poll();
+//       ...
+//   }
+//
+// A frame with more rectangles than the op queue holds waits for space as
+// it's queued.
+
+class AnimPlayer
+{
+
+public:
+
+    // Play 'anim' with its top left at (hor, ver), 'fps' frames per second,
+    // over and over if 'loop'.
+    AnimPlayer(Framebuffer &fb, int hor, int ver, const AnimationHdr *anim,
+               int fps, bool loop = true);
+
+    // Show the first frame now, and the rest from then on.
+    void start();
+
+    // Queue the next frame if it's due. Returns false once a non-looping
+    // animation has shown its last frame (or before start).
+    bool poll();
+
+    void stop()
+    {
+        _playing = false;
+    }
+
+    // frames shown since start
+    int frames_shown() const
+    {
+        return _shown;
+    }
+
+    // frame times missed since start
+    int frames_dropped() const
+    {
+        return _dropped;
+    }
+
+private:
+
+    Framebuffer &_fb;
+    int _hor, _ver;
+    const AnimationHdr *_anim;
+    const uint16_t *_data;
+    uint32_t _period_us;
+    bool _loop;
+
+    bool _playing;
+    int _pos;      // next record in _data
+    int _loop_pos; // record of the change to frame 1
+    int _frame;    // frame on the screen, 0..frames-1
+    uint32_t _due; // when the next is due (time_us_32)
+    int _shown;
+    int _dropped;
+
+    // queue the record at _pos, and move _pos past it
+    void show();
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "image_patch.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Short animations (a boot logo, a "connecting" spinner) stored as changes
+// from frame to frame.
+//
+// Sending every frame in full is its size in flash per frame, and its size
+// in spi time per frame. An Animation keeps the first frame (the keyframe),
+// then for each frame only the rectangles that changed from the one
+// before, found the way an ImagePatch's are (see image_patch.h). A
+// rectangle that is all one color is kept as just that color and sent as a
+// fill; others keep their pixels, sent straight from flash as Copy ops. The
+// keyframe is a fill of its top left pixel's color, then what differs from
+// that. A last change, from the last frame back to the first, lets it loop.
+//
+// Everything is sent with async ops, so AnimPlayer (see anim_player.h) can
+// play one at a frame rate without waiting on the display.
+//
+// The data is a stream of 16-bit words, a record per frame:
+//
+//   fills, then 'fills' times: x, y, wid, hgt, pixel
+//   copy_len, then copy_len words: x, y, wid, hgt, p1, p2, ... p(wid * hgt)
+//
+// with the copies in ImagePatch form. Pixel values are Pixel565::value().
+//
+// Like an ImagePatch, creating one at compile time takes two steps, since
+// the size must be known to declare its type:
+//
+//   static constexpr PixelImage<Pixel565, wid, hgt> frames[] = {...};
+//   static constexpr int n = sizeof(frames) / sizeof(frames[0]);
+//   static constexpr int len = anim_len(frames, n);
+//   static constexpr Animation<wid, hgt, len> spinner =
+//       anim_img<len>(frames, n);
+//
+// Only the Animation ends up in flash.
+
+struct AnimationHdr {
+    int wid;
+    int hgt;
+    int frames;
+    int len; // number of uint16_t in data
+};
+
+template <int w, int h, int n>
+struct Animation {
+    AnimationHdr hdr{w, h, 0, n};
+    uint16_t data[n];
+};
+
+// Color whose Pixel565 is 'value', for sending a pixel value with a fill.
+static constexpr Color anim_color(uint16_t value)
+{
+    static_assert(Pixel565::xfer_size == 16, "anim_color: 16-bit spi only");
+    return Color(uint8_t((value >> 8) & 0xf8), uint8_t((value >> 3) & 0xfc),
+                 uint8_t((value << 3) & 0xf8));
+}
+
+// Put the record for the change from 'from' to 'to', a word at a time. With
+// 'fill_all', the record starts with a fill of the whole frame in the color
+// of 'from' (then 'from' should be all that color).
+template <int wid, int hgt, typename PUT>
+static constexpr void anim_frame(const PixelImage<Pixel565, wid, hgt> &from,
+                                 const PixelImage<Pixel565, wid, hgt> &to,
+                                 bool fill_all, PUT put)
+{
+    ImagePatchRect rect[image_patch_rects_max]{};
+    const int n = image_patch_rects(from, to, rect);
+
+    auto solid = [&to](const ImagePatchRect &r) {
+        const uint16_t v = to.pixels[r.y * wid + r.x].value();
+        for (int y = r.y; y < (r.y + r.hgt); y++)
+            for (int x = r.x; x < (r.x + r.wid); x++)
+                if (to.pixels[y * wid + x].value() != v)
+                    return false;
+        return true;
+    };
+
+    int fills = fill_all ? 1 : 0;
+    int copy_len = 0;
+    for (int r = 0; r < n; r++) {
+        if (solid(rect[r]))
+            fills++;
+        else
+            copy_len += 4 + rect[r].wid * rect[r].hgt;
+    }
+    assert(copy_len <= 0xffff);
+
+    put(uint16_t(fills));
+    if (fill_all) {
+        put(0);
+        put(0);
+        put(uint16_t(wid));
+        put(uint16_t(hgt));
+        put(from.pixels[0].value());
+    }
+    for (int r = 0; r < n; r++) {
+        if (!solid(rect[r]))
+            continue;
+        put(uint16_t(rect[r].x));
+        put(uint16_t(rect[r].y));
+        put(uint16_t(rect[r].wid));
+        put(uint16_t(rect[r].hgt));
+        put(to.pixels[rect[r].y * wid + rect[r].x].value());
+    }
+
+    put(uint16_t(copy_len));
+    for (int r = 0; r < n; r++) {
+        if (solid(rect[r]))
+            continue;
+        put(uint16_t(rect[r].x));
+        put(uint16_t(rect[r].y));
+        put(uint16_t(rect[r].wid));
+        put(uint16_t(rect[r].hgt));
+        for (int y = rect[r].y; y < (rect[r].y + rect[r].hgt); y++)
+            for (int x = rect[r].x; x < (rect[r].x + rect[r].wid); x++)
+                put(to.pixels[y * wid + x].value());
+    }
+}
+
+// Put the records for all of 'frames': the keyframe, the changes to each
+// of the others, and the change back to the first.
+template <int wid, int hgt, typename PUT>
+static constexpr void anim_frames(const PixelImage<Pixel565, wid, hgt> *frames,
+                                  int n, PUT put)
+{
+    PixelImage<Pixel565, wid, hgt> bg{};
+    for (int i = 0; i < wid * hgt; i++)
+        bg.pixels[i] = frames[0].pixels[0];
+
+    anim_frame(bg, frames[0], true, put);
+    for (int f = 1; f < n; f++)
+        anim_frame(frames[f - 1], frames[f], false, put);
+    if (n > 1)
+        anim_frame(frames[n - 1], frames[0], false, put);
+}
+
+// number of uint16_t in the animation of the 'n' 'frames'
+template <int wid, int hgt>
+static constexpr int anim_len(const PixelImage<Pixel565, wid, hgt> *frames,
+                              int n)
+{
+    assert(n > 0);
+    int len = 0;
+    anim_frames(frames, n, [&len](uint16_t) { len++; });
+    return len;
+}
+
+// animation of the 'n' 'frames'; 'len' must be anim_len(frames, n)
+template <int len, int wid, int hgt>
+static constexpr Animation<wid, hgt, len>
+anim_img(const PixelImage<Pixel565, wid, hgt> *frames, int n)
+{
+    Animation<wid, hgt, len> anim{};
+    anim.hdr.frames = n;
+    int i = 0;
+    anim_frames(frames, n, [&anim, &i](uint16_t w) { anim.data[i++] = w; });
+    assert(i == len);
+    return anim;
+}
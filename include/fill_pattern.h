@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Small repeating tiles for filling rectangles (hatching, stripes,
+// checkerboards, textures).
+//
+// Framebuffer::fill_pattern fills a rectangle with a tile repeated across
+// and down it. Tft does it the way it does a solid fill, with dma and no
+// cpu per pixel: each row of the rectangle is one transfer that reads a row
+// of the tile over and over, using the dma's read address wrapping (ring)
+// mode. For that, rows must be a power of two pixels wide, and each row
+// aligned to its size, which FillPattern does.
+//
+// The tile is anchored to the screen, not the rectangle: pixel (hor, ver)
+// of the screen gets tile pixel (hor % wid, ver % hgt). Separate fills with
+// the same pattern then line up where they meet.
+//
+//   static constexpr FillPattern<8, 8> hatch =
+//       pattern_hatch<8>(Color::gray(), Color::black(), 1);
+//   fb.fill_pattern(hor, ver, wid, hgt, hatch);
+//
+// Like an image, the tile must stay put until the fill has finished; one
+// made at compile time is in flash.
+
+template <int w, int h>
+struct FillPattern {
+    static_assert(w > 0 && w <= 256 && (w & (w - 1)) == 0,
+                  "FillPattern: width must be a power of two up to 256");
+    static_assert(h > 0, "FillPattern: height must be positive");
+    alignas(w * sizeof(Pixel565)) Pixel565 pixels[w * h];
+};
+
+// Checkerboard of 'wid' / 2 x 'hgt' / 2 squares, 'c0' top left.
+template <int wid, int hgt>
+static constexpr FillPattern<wid, hgt> pattern_checker(Color c0, Color c1)
+{
+    FillPattern<wid, hgt> pat{};
+    for (int y = 0; y < hgt; y++)
+        for (int x = 0; x < wid; x++)
+            pat.pixels[y * wid + x] =
+                ((x < wid / 2) == (y < hgt / 2)) ? c0 : c1;
+    return pat;
+}
+
+// Diagonal lines 'thk' pixels wide in 'fg' over 'bg', 'size' apart, going
+// up to the right.
+template <int size>
+static constexpr FillPattern<size, size> pattern_hatch(Color bg, Color fg,
+                                                       int thk)
+{
+    FillPattern<size, size> pat{};
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+            pat.pixels[y * size + x] = ((x + y) % size) < thk ? fg : bg;
+    return pat;
+}
+
+// Horizontal stripes: 'thk' rows of 'c1', then the rest of 'hgt' rows of
+// 'c0'. One pixel wide is enough.
+template <int hgt>
+static constexpr FillPattern<1, hgt> pattern_stripes(Color c0, Color c1,
+                                                     int thk)
+{
+    FillPattern<1, hgt> pat{};
+    for (int y = 0; y < hgt; y++)
+        pat.pixels[y] = (y < thk) ? c1 : c0;
+    return pat;
+}
+
+// Tile from an image (e.g. a texture made with label_img or by hand).
+template <int wid, int hgt>
+static constexpr FillPattern<wid, hgt>
+pattern_img(const PixelImage<Pixel565, wid, hgt> &img)
+{
+    FillPattern<wid, hgt> pat{};
+    for (int i = 0; i < wid * hgt; i++)
+        pat.pixels[i] = img.pixels[i];
+    return pat;
+}
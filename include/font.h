@@ -2,6 +2,252 @@
 
 #include <cstdint>
 
+// Glyph data encodings. Each glyph is a w x h array of coverage values
+// (0 is background, 255 is foreground), row-major, starting at data + off.
+//
+//   Gray8  one byte per pixel
+//   Gray4  one nibble per pixel, high nibble first; coverage = nibble * 17
+//          (rows are not padded, so a row can start mid-byte)
+//   Rle4   nibbles as in Gray4, except that a zero nibble is followed by a
+//          count nibble n, and the two together are n + 1 pixels of zero
+//          coverage (most glyph pixels are empty, and they come in runs)
+//
+// Gray8 is what the font headers contain. The others are created from it
+// at compile time (see font_pack.h).
+enum class GlyphFormat : uint8_t { Gray8, Gray4, Rle4 };
+
+// Sequential reader for glyph coverage in any of the formats.
+class GlyphReader
+{
+
+public:
+
+    constexpr GlyphReader() :
+        GlyphReader(nullptr, GlyphFormat::Gray8)
+    {
+    }
+
+    constexpr GlyphReader(const uint8_t *p, GlyphFormat format) :
+        _p(p),
+        _format(format),
+        _odd(false),
+        _zeros(0)
+    {
+    }
+
+    // next coverage value, 0..255
+    constexpr uint8_t next()
+    {
+        if (_format == GlyphFormat::Gray8)
+            return *_p++;
+
+        if (_format == GlyphFormat::Gray4)
+            return nibble() * 17;
+
+        // Rle4
+        if (_zeros > 0) {
+            _zeros--;
+            return 0;
+        }
+        const uint8_t v = nibble();
+        if (v == 0)
+            _zeros = nibble(); // more zeros after this one
+        return v * 17;
+    }
+
+    // read 'n' coverage values into 'cov'
+    constexpr void read(uint8_t *cov, int n)
+    {
+        if (_format == GlyphFormat::Gray8) {
+            for (int i = 0; i < n; i++)
+                cov[i] = _p[i];
+            _p += n;
+        } else {
+            for (int i = 0; i < n; i++)
+                cov[i] = next();
+        }
+    }
+
+    // read 'n' coverage values, mapping each through 'lut' (256 entries)
+    // into 'dst'
+    template <typename T>
+    constexpr void read(T *dst, int n, const T *lut)
+    {
+        if (_format == GlyphFormat::Gray8) {
+            for (int i = 0; i < n; i++)
+                dst[i] = lut[_p[i]];
+            _p += n;
+        } else {
+            for (int i = 0; i < n; i++)
+                dst[i] = lut[next()];
+        }
+    }
+
+    // skip 'n' coverage values
+    constexpr void skip(int n)
+    {
+        if (_format == GlyphFormat::Gray8) {
+            _p += n;
+        } else {
+            while (n-- > 0)
+                next();
+        }
+    }
+
+private:
+
+    const uint8_t *_p;
+    GlyphFormat _format;
+    bool _odd;      // next nibble is the low one
+    uint8_t _zeros; // Rle4: zero pixels left in current run
+
+    constexpr uint8_t nibble()
+    {
+        uint8_t v = 0;
+        if (_odd)
+            v = *_p++ & 0x0f;
+        else
+            v = *_p >> 4;
+        _odd = !_odd;
+        return v;
+    }
+};
+
+// Everything needed to render one character, whatever kind of font it came
+// from. The character box is x_adv wide and the font's y_adv high; the w x h
+// glyph is at (x_off, y_off) within it, and may extend outside it.
+struct Glyph {
+    const uint8_t *data;
+    GlyphFormat format;
+    int8_t w;
+    int8_t h;
+    int8_t x_off;
+    int8_t y_off;
+    int8_t x_adv;
+
+    constexpr GlyphReader reader() const
+    {
+        return GlyphReader(data, format);
+    }
+};
+
+// Text is UTF-8. Characters are decoded to Unicode codepoints, which is
+// what the font methods below take.
+
+static constexpr uint32_t utf8_invalid = 0xfffd; // U+FFFD replacement char
+
+// Decode the character at s and advance s past it (s must not be at the
+// terminating '\0'). A malformed sequence decodes as utf8_invalid and
+// consumes one byte, so decoding always makes progress and never reads past
+// the terminator.
+static constexpr uint32_t utf8_next(const char *&s)
+{
+    const uint8_t b0 = uint8_t(*s++);
+    if (b0 < 0x80)
+        return b0;
+
+    int n = 0; // continuation bytes
+    uint32_t cp = 0;
+    if ((b0 & 0xe0) == 0xc0) {
+        n = 1;
+        cp = b0 & 0x1f;
+    } else if ((b0 & 0xf0) == 0xe0) {
+        n = 2;
+        cp = b0 & 0x0f;
+    } else if ((b0 & 0xf8) == 0xf0) {
+        n = 3;
+        cp = b0 & 0x07;
+    } else {
+        return utf8_invalid; // stray continuation byte or bad lead byte
+    }
+
+    const char *p = s;
+    for (int i = 0; i < n; i++) {
+        const uint8_t b = uint8_t(*p);
+        if ((b & 0xc0) != 0x80)
+            return utf8_invalid; // truncated (this catches '\0' too)
+        cp = (cp << 6) | (b & 0x3f);
+        p++;
+    }
+
+    // reject overlong encodings, surrogates, and anything past U+10FFFF
+    const uint32_t cp_min = (n == 1) ? 0x80 : (n == 2) ? 0x800 : 0x10000;
+    if (cp < cp_min || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+        return utf8_invalid;
+
+    s = p;
+    return cp;
+}
+
+// Kerning: adjustments to the spacing of particular pairs of characters
+// (e.g. "AV", "To"), added to the x position of the second character.
+//
+// The pairs are sorted by (left, right) so lookup is a binary search. The
+// font headers don't include kerning; a table is attached to a copy of the
+// font (see font_kern() in font_pack.h and roboto_kern.h).
+
+struct KernPair {
+    uint16_t left;
+    uint16_t right;
+    int8_t adj; // pixels, usually negative
+};
+
+struct Kerning {
+    const KernPair *pairs;
+    int cnt;
+
+    constexpr int adjust(uint32_t left, uint32_t right) const
+    {
+        if (left > 0xffff || right > 0xffff)
+            return 0;
+        const uint32_t key = (left << 16) | right;
+        int lo = 0;
+        int hi = cnt - 1;
+        while (lo <= hi) {
+            const int mid = (lo + hi) / 2;
+            const uint32_t k =
+                (uint32_t(pairs[mid].left) << 16) | pairs[mid].right;
+            if (k == key)
+                return pairs[mid].adj;
+            if (k < key)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+        return 0;
+    }
+};
+
+// Width of UTF-8 string 's' in 'font', including kerning. This is how all
+// the fonts implement width(s); anything that lays out text must match it,
+// i.e. step through the characters adding kerning(prev, c) then width(c).
+template <typename FONT>
+static constexpr int text_width(const FONT &font, const char *s)
+{
+    int w = 0;
+    uint32_t prev = 0;
+    while (*s != '\0') {
+        const uint32_t c = utf8_next(s);
+        w += font.kerning(prev, c) + font.width(c);
+        prev = c;
+    }
+    return w;
+}
+
+// Fonts are used through a common set of constexpr methods, so anything
+// that renders text can be written once as a template on the font type:
+//
+//   printable(c)   whether the font has an entry for codepoint c
+//   glyph(c)       Glyph for c (printable(c) must be true)
+//   height()       character box height
+//   width(c)       character box width (0 if not printable)
+//   width(s)       sum of character box widths in UTF-8 string s, kerned
+//   max_width()    widest character box
+//   kerning(a, b)  adjustment to the position of b when it follows a
+//
+// Font covers all of 0..127. FontRange (below) covers a contiguous subset,
+// with smaller table entries. FontSparse covers any set of characters.
+
 struct Font {
     int8_t y_adv;
     int8_t x_adv_max;
@@ -18,32 +264,153 @@ struct Font {
         int8_t x_adv;
     } info[128];
     const uint8_t *data;
+    GlyphFormat format = GlyphFormat::Gray8;
+    const Kerning *kern = nullptr;
+
+    constexpr bool printable(uint32_t c) const { return c < 128; }
 
-    constexpr bool printable(char c) const
+    constexpr Glyph glyph(uint32_t c) const
     {
-        // If 'char' is signed, we need c >= 0
-        // If 'char' is unsigned, we need c <= 127
-        // Either case means (c & 0x80) == 0
-        return (c & 0x80) == 0;
+        return Glyph{data + info[c].off, format, info[c].w, info[c].h,
+                     info[c].x_off, info[c].y_off, info[c].x_adv};
     }
 
     constexpr int8_t height() const { return y_adv; }
 
-    constexpr int8_t width(char c) const
+    constexpr int8_t width(uint32_t c) const
     {
-        return printable(c) ? info[int(c)].x_adv : 0;
+        return printable(c) ? info[c].x_adv : 0;
     }
 
-    constexpr int width(const char *s) const
+    constexpr int width(const char *s) const { return text_width(*this, s); }
+
+    constexpr int8_t max_width() const { return x_adv_max; }
+
+    constexpr int kerning(uint32_t a, uint32_t b) const
     {
-        int w = 0;
-        while (*s != '\0') {
-            char c = *s++;
-            if (printable(c))
-                w += info[int(c)].x_adv;
-        }
-        return w;
+        return (kern != nullptr) ? kern->adjust(a, b) : 0;
     }
+};
+
+
+// Font covering only the characters first..last.
+//
+// Each entry is 8 bytes (16-bit offset and byte-sized metrics), compared to
+// 12 bytes for each of Font's 128 entries, and there are only as many as the
+// range needs. This is usually created at compile time from a Font, e.g. a
+// large font with only the characters needed for numbers (see font_range()
+// in font_pack.h).
+//
+// Characters in the range with no glyph have w = h = x_adv = 0.
+
+struct FontRangeInfo {
+    uint16_t off;
+    int8_t w;
+    int8_t h;
+    int8_t x_off;
+    int8_t y_off;
+    int8_t x_adv;
+};
+
+struct FontRange {
+    int8_t y_adv;
+    int8_t x_adv_max;
+    uint8_t first; // first character in range
+    uint8_t last;  // last character in range
+    GlyphFormat format;
+    const FontRangeInfo *info; // last - first + 1 entries
+    const uint8_t *data;
+    const Kerning *kern = nullptr;
+
+    constexpr bool printable(uint32_t c) const
+    {
+        return first <= c && c <= last;
+    }
+
+    constexpr Glyph glyph(uint32_t c) const
+    {
+        const FontRangeInfo &i = info[c - first];
+        return Glyph{data + i.off, format, i.w, i.h, i.x_off, i.y_off, i.x_adv};
+    }
+
+    constexpr int8_t height() const { return y_adv; }
+
+    constexpr int8_t width(uint32_t c) const
+    {
+        return printable(c) ? info[c - first].x_adv : 0;
+    }
+
+    constexpr int width(const char *s) const { return text_width(*this, s); }
 
     constexpr int8_t max_width() const { return x_adv_max; }
+
+    constexpr int kerning(uint32_t a, uint32_t b) const
+    {
+        return (kern != nullptr) ? kern->adjust(a, b) : 0;
+    }
+};
+
+
+// Font with glyphs for an arbitrary set of characters, e.g. ASCII plus a few
+// accented letters, the degree sign, and arrows.
+//
+// Glyphs are found through a two-level table indexed by codepoint:
+//
+//   pages[c >> 8]                     0 if the 256-character page containing
+//                                     c has no glyphs, else 1 + block number
+//   blocks[block * 256 + (c & 0xff)]  0 if c has no glyph, else 1 + index
+//                                     into info
+//
+// so a lookup is two table reads however many glyphs there are. Each page
+// in use costs a 512-byte block; text in one script touches only a few
+// pages. Only U+0000..U+FFFF is supported.
+//
+// This is created at compile time from glyphs gathered from other fonts or
+// drawn procedurally (see font_sparse() in font_pack.h).
+
+struct FontSparse {
+    int8_t y_adv;
+    int8_t x_adv_max;
+    GlyphFormat format;
+    const uint8_t *pages;      // 256 entries
+    const uint16_t *blocks;    // 256 entries per page in use
+    const FontRangeInfo *info; // one per glyph
+    const uint8_t *data;
+    const Kerning *kern = nullptr;
+
+    // index into info for codepoint c, or -1 if there is no glyph
+    constexpr int index(uint32_t c) const
+    {
+        if (c > 0xffff)
+            return -1;
+        const int page = pages[c >> 8];
+        if (page == 0)
+            return -1;
+        return int(blocks[(page - 1) * 256 + (c & 0xff)]) - 1;
+    }
+
+    constexpr bool printable(uint32_t c) const { return index(c) >= 0; }
+
+    constexpr Glyph glyph(uint32_t c) const
+    {
+        const FontRangeInfo &i = info[index(c)];
+        return Glyph{data + i.off, format, i.w, i.h, i.x_off, i.y_off, i.x_adv};
+    }
+
+    constexpr int8_t height() const { return y_adv; }
+
+    constexpr int8_t width(uint32_t c) const
+    {
+        const int i = index(c);
+        return (i >= 0) ? info[i].x_adv : 0;
+    }
+
+    constexpr int width(const char *s) const { return text_width(*this, s); }
+
+    constexpr int8_t max_width() const { return x_adv_max; }
+
+    constexpr int kerning(uint32_t a, uint32_t b) const
+    {
+        return (kern != nullptr) ? kern->adjust(a, b) : 0;
+    }
 };
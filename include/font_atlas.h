@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "font.h"
+#include "glyph_raster.h"
+#include "pixel_565.h"
+
+// Pre-rendered fonts.
+//
+// A FontAtlas has every character box of a font (or a range of it) already
+// blended in one pair of colors, stored in flash. Printing with one is just
+// an async Copy op per character straight from flash (see
+// Framebuffer::print(..., const FontAtlas &, ...)): no blending at all, and
+// the call returns as soon as the ops are queued. This is what the digit
+// images made with label_img do for numbers, for any text.
+//
+// The cost is flash: each character box is x_adv * y_adv pixels, e.g. about
+// 55K for roboto_24 ' '..'~'. A range of just the characters needed (digits,
+// say) is much less.
+//
+// Building one takes three steps, since the size must be known to declare
+// its type:
+//
+//   inline constexpr int a_len = font_atlas_len(f, '0', '9');
+//   inline constexpr FontAtlasData<'0', '9', a_len> a_data =
+//       font_atlas_data<'0', '9', a_len>(f, fg, bg);
+//   inline constexpr FontAtlas a = font_atlas(f, a_data);
+//
+// Measurement (width, kerning) is the same as the source font's. When
+// kerning makes boxes overlap, the later box covers the earlier one.
+
+struct FontAtlasInfo {
+    uint32_t off; // first pixel of box in pixels
+    int8_t x_adv;
+};
+
+struct FontAtlas {
+    int8_t y_adv;
+    int8_t x_adv_max;
+    uint8_t first; // first character in atlas
+    uint8_t last;  // last character in atlas
+    const FontAtlasInfo *info; // last - first + 1 entries
+    const Pixel565 *pixels;    // character boxes, x_adv * y_adv each
+    const Kerning *kern = nullptr;
+
+    constexpr bool printable(uint32_t c) const
+    {
+        return first <= c && c <= last;
+    }
+
+    // pixels of c's box (printable(c) must be true)
+    constexpr const Pixel565 *box(uint32_t c) const
+    {
+        return pixels + info[c - first].off;
+    }
+
+    constexpr int8_t height() const { return y_adv; }
+
+    constexpr int8_t width(uint32_t c) const
+    {
+        return printable(c) ? info[c - first].x_adv : 0;
+    }
+
+    constexpr int width(const char *s) const { return text_width(*this, s); }
+
+    constexpr int8_t max_width() const { return x_adv_max; }
+
+    constexpr int kerning(uint32_t a, uint32_t b) const
+    {
+        return (kern != nullptr) ? kern->adjust(a, b) : 0;
+    }
+};
+
+template <int first, int last, int len>
+struct FontAtlasData {
+    static_assert(0 <= first && first <= last && last < 256,
+                  "FontAtlasData: bad range");
+    FontAtlasInfo info[last - first + 1];
+    Pixel565 pixels[len > 0 ? len : 1];
+};
+
+// number of pixels in the boxes for first..last of 'font'
+template <typename FONT>
+static constexpr int font_atlas_len(const FONT &font, int first, int last)
+{
+    int len = 0;
+    for (int c = first; c <= last; c++)
+        len += font.width(uint32_t(c)) * font.height();
+    return len;
+}
+
+// render boxes for first..last of 'font', 'fg' on 'bg'
+template <int first, int last, int len, typename FONT>
+static constexpr FontAtlasData<first, last, len>
+font_atlas_data(const FONT &font, Color fg, Color bg)
+{
+    FontAtlasData<first, last, len> fd{};
+    const BlendLut<Pixel565> lut(bg, fg);
+    uint32_t off = 0;
+    for (int c = first; c <= last; c++) {
+        FontAtlasInfo &info = fd.info[c - first];
+        info.off = off;
+        info.x_adv = font.width(uint32_t(c));
+        if (info.x_adv == 0)
+            continue; // not in font
+        GlyphRaster<Pixel565> raster(font.glyph(uint32_t(c)), lut);
+        for (int row = 0; row < font.height(); row++) {
+            raster.row(fd.pixels + off);
+            off += info.x_adv;
+        }
+    }
+    assert(off == uint32_t(len));
+    return fd;
+}
+
+template <int first, int last, int len, typename FONT>
+static constexpr FontAtlas font_atlas(const FONT &font,
+                                      const FontAtlasData<first, last, len> &fd)
+{
+    int8_t x_adv_max = 0;
+    for (int c = first; c <= last; c++)
+        if (fd.info[c - first].x_adv > x_adv_max)
+            x_adv_max = fd.info[c - first].x_adv;
+    return FontAtlas{font.height(), x_adv_max, uint8_t(first), uint8_t(last),
+                     fd.info,       fd.pixels, font.kern};
+}
@@ -0,0 +1,419 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "font.h"
+
+// Compile-time conversion of a font's glyph data to a more compact encoding
+// (see GlyphFormat in font.h).
+//
+// The font headers store 8 bits of coverage per pixel. Four bits is visually
+// indistinguishable for antialiased text, and halves the size. Run-length
+// coding the empty pixels, which dominate most glyphs, shrinks it further.
+//
+// Converting a font takes three steps, since the size of the packed data
+// must be known to declare its type:
+//
+//   inline constexpr int f_len = font_pack_len(f, GlyphFormat::Rle4);
+//   inline constexpr FontData<f_len> f_data =
+//       font_pack_data<f_len>(f, GlyphFormat::Rle4);
+//   inline constexpr Font f_rle4 =
+//       font_pack(f, f_data.data, GlyphFormat::Rle4);
+//
+// The original font is only used at compile time, so only the packed data
+// ends up in flash. roboto_packed.h does this for all the roboto sizes.
+
+template <int len>
+struct FontData {
+    uint8_t data[len];
+};
+
+// 8-bit coverage to 4-bit, rounded
+static constexpr uint8_t glyph_pack_4(uint8_t cov)
+{
+    return uint8_t((cov * 15 + 127) / 255);
+}
+
+// Pack one glyph's 'n' coverage values from 'gs' (Gray8), calling emit(byte)
+// for each byte of packed data. Each glyph starts on a byte boundary.
+template <typename EMIT>
+static constexpr void glyph_pack(const uint8_t *gs, int n, GlyphFormat format,
+                                 EMIT emit)
+{
+    if (format == GlyphFormat::Gray8) {
+        for (int i = 0; i < n; i++)
+            emit(gs[i]);
+        return;
+    }
+
+    // Gray4 and Rle4 are nibble streams, high nibble first
+    uint8_t b = 0;
+    bool odd = false;
+    auto nibble = [&b, &odd, &emit](uint8_t v) {
+        if (odd)
+            emit(uint8_t(b | v));
+        else
+            b = uint8_t(v << 4);
+        odd = !odd;
+    };
+
+    int i = 0;
+    while (i < n) {
+        const uint8_t v = glyph_pack_4(gs[i]);
+        if (v == 0 && format == GlyphFormat::Rle4) {
+            // zero, then count of additional zeros (up to 15)
+            int run = 1;
+            while ((i + run) < n && run < 16 && glyph_pack_4(gs[i + run]) == 0)
+                run++;
+            nibble(0);
+            nibble(uint8_t(run - 1));
+            i += run;
+        } else {
+            nibble(v);
+            i++;
+        }
+    }
+
+    if (odd)
+        emit(b); // last byte is half full
+}
+
+// Walk all glyphs in 'font' in code order, calling start(c, off) when
+// glyph c starts at byte 'off' in the packed data, and emit(byte) for each
+// byte of packed data.
+template <typename START, typename EMIT>
+static constexpr void font_pack_walk(const Font &font, GlyphFormat format,
+                                     START start, EMIT emit)
+{
+    assert(font.format == GlyphFormat::Gray8);
+    int off = 0;
+    for (int c = 0; c < 128; c++) {
+        if (font.info[c].off < 0)
+            continue; // no glyph
+        start(c, off);
+        const int n = font.info[c].w * font.info[c].h;
+        glyph_pack(font.data + font.info[c].off, n, format,
+                   [&off, &emit](uint8_t b) {
+                       emit(b);
+                       off++;
+                   });
+    }
+}
+
+// number of bytes of glyph data in 'font' packed as 'format'
+static constexpr int font_pack_len(const Font &font, GlyphFormat format)
+{
+    int len = 0;
+    font_pack_walk(
+        font, format, [](int, int) {}, [&len](uint8_t) { len++; });
+    return len;
+}
+
+// glyph data in 'font' packed as 'format'; 'len' must be font_pack_len()
+template <int len>
+static constexpr FontData<len> font_pack_data(const Font &font,
+                                              GlyphFormat format)
+{
+    FontData<len> fd{};
+    int i = 0;
+    font_pack_walk(
+        font, format, [](int, int) {},
+        [&fd, &i](uint8_t b) { fd.data[i++] = b; });
+    return fd;
+}
+
+// copy of 'font' using 'data' (from font_pack_data) in 'format'
+static constexpr Font font_pack(const Font &font, const uint8_t *data,
+                                GlyphFormat format)
+{
+    Font packed = font;
+    packed.data = data;
+    packed.format = format;
+    font_pack_walk(
+        font, format, [&packed](int c, int off) { packed.info[c].off = off; },
+        [](uint8_t) {});
+    return packed;
+}
+
+
+// Subsetting: a FontRange with only the characters first..last of a Font,
+// optionally packed at the same time. As with packing, this takes a few
+// steps so the sizes are known:
+//
+//   inline constexpr int f_len = font_range_len(f, '-', ':', format);
+//   inline constexpr FontRangeData<'-', ':', f_len> f_data =
+//       font_range_data<'-', ':', f_len>(f, format);
+//   inline constexpr FontRange f_num = font_range(f, f_data, format);
+//
+// ('-' through ':' is "-./0123456789:", enough for numbers and times.)
+
+template <int first, int last, int len>
+struct FontRangeData {
+    static_assert(0 <= first && first <= last && last < 128,
+                  "FontRangeData: bad range");
+    FontRangeInfo info[last - first + 1];
+    uint8_t data[len];
+};
+
+// Walk glyphs first..last; see font_pack_walk.
+template <typename START, typename EMIT>
+static constexpr void font_range_walk(const Font &font, int first, int last,
+                                      GlyphFormat format, START start,
+                                      EMIT emit)
+{
+    assert(font.format == GlyphFormat::Gray8);
+    int off = 0;
+    for (int c = first; c <= last; c++) {
+        start(c, off);
+        if (font.info[c].off < 0)
+            continue; // no glyph
+        const int n = font.info[c].w * font.info[c].h;
+        glyph_pack(font.data + font.info[c].off, n, format,
+                   [&off, &emit](uint8_t b) {
+                       emit(b);
+                       off++;
+                   });
+    }
+}
+
+// number of bytes of glyph data for first..last of 'font' packed as 'format'
+static constexpr int font_range_len(const Font &font, int first, int last,
+                                    GlyphFormat format = GlyphFormat::Gray8)
+{
+    int len = 0;
+    font_range_walk(
+        font, first, last, format, [](int, int) {},
+        [&len](uint8_t) { len++; });
+    return len;
+}
+
+template <int first, int last, int len>
+static constexpr FontRangeData<first, last, len>
+font_range_data(const Font &font, GlyphFormat format = GlyphFormat::Gray8)
+{
+    FontRangeData<first, last, len> fd{};
+    int i = 0;
+    font_range_walk(
+        font, first, last, format,
+        [&font, &fd](int c, int off) {
+            assert(off <= UINT16_MAX);
+            FontRangeInfo &info = fd.info[c - first];
+            info.off = uint16_t(off);
+            if (font.info[c].off >= 0) {
+                info.w = font.info[c].w;
+                info.h = font.info[c].h;
+                info.x_off = font.info[c].x_off;
+                info.y_off = font.info[c].y_off;
+                info.x_adv = font.info[c].x_adv;
+            }
+        },
+        [&fd, &i](uint8_t b) { fd.data[i++] = b; });
+    return fd;
+}
+
+template <int first, int last, int len>
+static constexpr FontRange
+font_range(const Font &font, const FontRangeData<first, last, len> &fd,
+           GlyphFormat format = GlyphFormat::Gray8)
+{
+    int8_t x_adv_max = 0;
+    for (int c = first; c <= last; c++)
+        if (fd.info[c - first].x_adv > x_adv_max)
+            x_adv_max = fd.info[c - first].x_adv;
+    return FontRange{font.y_adv, x_adv_max, uint8_t(first), uint8_t(last),
+                     format,      fd.info,   fd.data,        font.kern};
+}
+
+
+// Sparse fonts: a FontSparse with all the glyphs of a Font plus any number
+// of others, each given as a codepoint and a Gray8 Glyph (from another font,
+// or drawn; see font_symbol.h). As above, this takes a few steps:
+//
+//   inline constexpr SparseGlyph f_extra[] = {
+//       {0x00b0, degree_glyph}, // °
+//       {0x2192, arrow_glyph},  // →
+//   };
+//   inline constexpr FontSparseSize f_size =
+//       font_sparse_size(f, f_extra, 2, format);
+//   inline constexpr FontSparseData<f_size.glyphs, f_size.pages, f_size.len>
+//       f_data = font_sparse_data<f_size.glyphs, f_size.pages, f_size.len>(
+//           f, f_extra, 2, format);
+//   inline constexpr FontSparse f_sparse = font_sparse(f, f_data, format);
+//
+// The extra codepoints must be above 127 (the Font supplies 0..127), at most
+// 0xffff, and not repeated.
+
+struct SparseGlyph {
+    uint32_t cp;
+    Glyph glyph;
+};
+
+struct FontSparseSize {
+    int glyphs;
+    int pages;
+    int len;
+};
+
+template <int glyphs, int pages, int len>
+struct FontSparseData {
+    uint8_t page[256];
+    uint16_t block[pages * 256];
+    FontRangeInfo info[glyphs];
+    uint8_t data[len];
+};
+
+// Walk the glyphs of 'font' then 'extra', calling start(cp, off, glyph) when
+// a glyph starts at byte 'off' in the packed data, and emit(byte) for each
+// byte of packed data.
+template <typename START, typename EMIT>
+static constexpr void font_sparse_walk(const Font &font,
+                                       const SparseGlyph *extra, int extra_cnt,
+                                       GlyphFormat format, START start,
+                                       EMIT emit)
+{
+    assert(font.format == GlyphFormat::Gray8);
+    int off = 0;
+    auto add = [&off, &start, &emit, format](uint32_t cp, const Glyph &g) {
+        assert(g.format == GlyphFormat::Gray8);
+        start(cp, off, g);
+        glyph_pack(g.data, g.w * g.h, format, [&off, &emit](uint8_t b) {
+            emit(b);
+            off++;
+        });
+    };
+    for (int c = 0; c < 128; c++)
+        if (font.info[c].off >= 0)
+            add(uint32_t(c), font.glyph(c));
+    for (int i = 0; i < extra_cnt; i++) {
+        assert(127 < extra[i].cp && extra[i].cp <= 0xffff);
+        add(extra[i].cp, extra[i].glyph);
+    }
+}
+
+static constexpr FontSparseSize
+font_sparse_size(const Font &font, const SparseGlyph *extra, int extra_cnt,
+                 GlyphFormat format = GlyphFormat::Gray8)
+{
+    FontSparseSize size{0, 0, 0};
+    bool used[256] = {};
+    font_sparse_walk(
+        font, extra, extra_cnt, format,
+        [&size, &used](uint32_t cp, int, const Glyph &) {
+            size.glyphs++;
+            if (!used[cp >> 8]) {
+                used[cp >> 8] = true;
+                size.pages++;
+            }
+        },
+        [&size](uint8_t) { size.len++; });
+    return size;
+}
+
+template <int glyphs, int pages, int len>
+static constexpr FontSparseData<glyphs, pages, len>
+font_sparse_data(const Font &font, const SparseGlyph *extra, int extra_cnt,
+                 GlyphFormat format = GlyphFormat::Gray8)
+{
+    FontSparseData<glyphs, pages, len> fd{};
+    int pages_used = 0;
+    int glyph = 0;
+    int i = 0;
+    font_sparse_walk(
+        font, extra, extra_cnt, format,
+        [&fd, &pages_used, &glyph](uint32_t cp, int off, const Glyph &g) {
+            uint8_t &page = fd.page[cp >> 8];
+            if (page == 0)
+                page = uint8_t(++pages_used);
+            uint16_t &entry = fd.block[(page - 1) * 256 + (cp & 0xff)];
+            assert(entry == 0); // repeated codepoint
+            entry = uint16_t(glyph + 1);
+            assert(off <= UINT16_MAX);
+            fd.info[glyph] = FontRangeInfo{uint16_t(off), g.w,     g.h,
+                                           g.x_off,       g.y_off, g.x_adv};
+            glyph++;
+        },
+        [&fd, &i](uint8_t b) { fd.data[i++] = b; });
+    return fd;
+}
+
+template <int glyphs, int pages, int len>
+static constexpr FontSparse
+font_sparse(const Font &font, const FontSparseData<glyphs, pages, len> &fd,
+            GlyphFormat format = GlyphFormat::Gray8)
+{
+    int8_t x_adv_max = 0;
+    for (int i = 0; i < glyphs; i++)
+        if (fd.info[i].x_adv > x_adv_max)
+            x_adv_max = fd.info[i].x_adv;
+    return FontSparse{font.y_adv, x_adv_max, format,   fd.page,
+                      fd.block,   fd.info,   fd.data, font.kern};
+}
+
+
+// Kerning tables. Pairs are specified in 1/1000 em so one list serves every
+// size of a typeface, then scaled to pixels for a particular size (pairs
+// that round to zero are dropped):
+//
+//   inline constexpr int k_len = kern_len(pairs_em, pairs_cnt, em);
+//   inline constexpr KernTable<k_len> k_tab =
+//       kern_table<k_len>(pairs_em, pairs_cnt, em);
+//   inline constexpr Kerning k{k_tab.pairs, k_len};
+//   inline constexpr Font f_kerned = font_kern(f, k);
+//
+// 'em' is the size of an em in pixels. The list must be sorted by
+// (left, right).
+
+struct KernPairEm {
+    uint16_t left;
+    uint16_t right;
+    int16_t adj; // 1/1000 em
+};
+
+template <int len>
+struct KernTable {
+    KernPair pairs[len > 0 ? len : 1];
+};
+
+// adjustment in 1/1000 em scaled to pixels, rounded
+static constexpr int kern_scale(int adj, int em)
+{
+    const int v = adj * em;
+    return (v >= 0 ? v + 500 : v - 500) / 1000;
+}
+
+static constexpr int kern_len(const KernPairEm *src, int cnt, int em)
+{
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        assert(i == 0 || src[i - 1].left < src[i].left ||
+               (src[i - 1].left == src[i].left &&
+                src[i - 1].right < src[i].right)); // sorted
+        if (kern_scale(src[i].adj, em) != 0)
+            len++;
+    }
+    return len;
+}
+
+template <int len>
+static constexpr KernTable<len> kern_table(const KernPairEm *src, int cnt,
+                                           int em)
+{
+    KernTable<len> kt{};
+    int n = 0;
+    for (int i = 0; i < cnt; i++) {
+        const int adj = kern_scale(src[i].adj, em);
+        if (adj != 0)
+            kt.pairs[n++] = KernPair{src[i].left, src[i].right, int8_t(adj)};
+    }
+    return kt;
+}
+
+// copy of 'font' (Font, FontRange, or FontSparse) using 'kern'
+template <typename FONT>
+static constexpr FONT font_kern(const FONT &font, const Kerning &kern)
+{
+    FONT kerned = font;
+    kerned.kern = &kern;
+    return kerned;
+}
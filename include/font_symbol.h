@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+#include "font.h"
+
+// Procedurally drawn glyphs for a few symbols the roboto fonts don't have
+// (they are ASCII only), for adding to a FontSparse (see font_pack.h).
+//
+// Each symbol is drawn into a w x h box with 4x4 supersampling for
+// antialiasing, at compile time:
+//
+//   inline constexpr SymbolData<8, 8> deg = symbol_data<8, 8>(Symbol::Degree);
+//   inline constexpr Glyph deg_glyph = symbol_glyph(deg, 1, 5, 10);
+
+enum class Symbol {
+    Degree,     // U+00B0 °
+    ArrowLeft,  // U+2190 ←
+    ArrowUp,    // U+2191 ↑
+    ArrowRight, // U+2192 →
+    ArrowDown,  // U+2193 ↓
+};
+
+template <int w, int h>
+struct SymbolData {
+    uint8_t data[w * h];
+};
+
+// whether point (x, y) in the unit square is inside symbol 's'
+static constexpr bool symbol_inside(Symbol s, float x, float y)
+{
+    if (s == Symbol::Degree) {
+        // ring
+        const float dx = x - 0.5f;
+        const float dy = y - 0.5f;
+        const float d2 = dx * dx + dy * dy;
+        return d2 <= 0.25f && d2 >= 0.09f; // radius 0.3 to 0.5
+    }
+
+    // arrows: map to a right-pointing arrow
+    if (s == Symbol::ArrowLeft) {
+        x = 1.0f - x;
+    } else if (s == Symbol::ArrowUp) {
+        const float t = x;
+        x = 1.0f - y;
+        y = t;
+    } else if (s == Symbol::ArrowDown) {
+        const float t = x;
+        x = y;
+        y = t;
+    }
+
+    // head: triangle, point at (1, 0.5), base at x = 0.45
+    if (x >= 0.45f) {
+        const float dy = (y > 0.5f) ? (y - 0.5f) : (0.5f - y);
+        return dy <= 0.5f * (1.0f - x) / 0.55f;
+    }
+    // shaft
+    return y >= 0.4f && y <= 0.6f;
+}
+
+template <int w, int h>
+static constexpr SymbolData<w, h> symbol_data(Symbol s)
+{
+    constexpr int ss = 4; // supersampling in each direction
+    SymbolData<w, h> sd{};
+    for (int row = 0; row < h; row++) {
+        for (int col = 0; col < w; col++) {
+            int in = 0;
+            for (int sy = 0; sy < ss; sy++) {
+                for (int sx = 0; sx < ss; sx++) {
+                    const float x = (col * ss + sx + 0.5f) / (w * ss);
+                    const float y = (row * ss + sy + 0.5f) / (h * ss);
+                    if (symbol_inside(s, x, y))
+                        in++;
+                }
+            }
+            sd.data[row * w + col] = uint8_t(in * 255 / (ss * ss));
+        }
+    }
+    return sd;
+}
+
+// Glyph for symbol data placed at (x_off, y_off) in a character box x_adv
+// wide (the height is the font's)
+template <int w, int h>
+static constexpr Glyph symbol_glyph(const SymbolData<w, h> &sd, int x_off,
+                                    int y_off, int x_adv)
+{
+    return Glyph{sd.data,       GlyphFormat::Gray8, int8_t(w),    int8_t(h),
+                 int8_t(x_off), int8_t(y_off),      int8_t(x_adv)};
+}
@@ -3,8 +3,17 @@
 #include <cassert>
 
 #include "color.h"
+#include "fill_pattern.h"
 #include "font.h"
+#include "font_atlas.h"
+#include "glyph_cache.h"
+#include "image_patch.h"
+#include "indexed_image.h"
+#include "mask_image.h"
 #include "pixel_image.h"
+#include "rle_image.h"
+#include "sprite_image.h"
+#include "trace.h"
 
 
 class Framebuffer
@@ -72,6 +81,21 @@ public:
         Top = +1,    // draw reference point and below
     };
 
+    // Orientation of content drawn by the write and print methods that take
+    // one, relative to the screen: rotated clockwise, after being mirrored
+    // left-right for the Mirror ones. Rotated by 90 or 270 degrees, content
+    // 'wid' x 'hgt' covers 'hgt' x 'wid' on the screen.
+    enum class Orient {
+        None,
+        Cw90,
+        Cw180,
+        Cw270,
+        Mirror,
+        MirrorCw90,
+        MirrorCw180,
+        MirrorCw270,
+    };
+
     virtual void set_rotation(Rotation r)
     {
         // subclass should do most of the work
@@ -109,10 +133,77 @@ public:
     // fill rectangle
     virtual void fill_rect(int h, int v, int wid, int hgt, const Color c);
 
+    // fill rectangle with a repeating tile (see fill_pattern.h)
+    // 'pattern' is 'pat_wid' x 'pat_hgt' pixels, laid out as a FillPattern
+    virtual void fill_pattern(int h, int v, int wid, int hgt,
+                              const Pixel565 *pattern, int pat_wid,
+                              int pat_hgt) = 0;
+
+    template <int pat_wid, int pat_hgt>
+    void fill_pattern(int h, int v, int wid, int hgt,
+                      const FillPattern<pat_wid, pat_hgt> &pattern)
+    {
+        fill_pattern(h, v, wid, hgt, pattern.pixels, pat_wid, pat_hgt);
+    }
+
     // write array of pixels to screen
     virtual void write(int hor, int ver, const PixelImageHdr *image,
                        HAlign align = HAlign::Left) = 0;
 
+    // write the part of an image with its top left at (x, y) in the image
+    // and 'wid' x 'hgt' pixels, with its top left at (hor, ver) on screen
+    virtual void write(int hor, int ver, const PixelImageHdr *image, int x,
+                       int y, int wid, int hgt) = 0;
+
+    // Write a view of an image. Parts off the screen are cropped, so this
+    // can draw images partly off the screen (e.g. sliding in from an edge).
+    void write(int hor, int ver, const PixelImageView &view,
+               HAlign align = HAlign::Left);
+
+    // Write an image rotated and/or mirrored. (hor, ver) is the top left
+    // of where it goes on the screen, which must be entirely on the screen.
+    virtual void write(int hor, int ver, const PixelImageHdr *image,
+                       Orient orient) = 0;
+
+    // Write an image scaled up 'sx' times across and 'sy' times down, each
+    // pixel becoming an sx x sy block (nearest neighbor). The scaled image
+    // must be entirely on the screen.
+    virtual void write_scaled(int hor, int ver, const PixelImageHdr *image,
+                              int sx, int sy) = 0;
+
+    // Change the image at (hor, ver) from one to another by writing the
+    // rectangles in 'patch' (see image_patch.h). Parts off the screen are
+    // cropped.
+    virtual void write_patch(int hor, int ver,
+                             const ImagePatchHdr *patch) = 0;
+
+    // Write rectangles of pixels in ImagePatch form (records of x, y, wid,
+    // hgt, then the pixels; see image_patch.h), 'len' words of them,
+    // offset by (hor, ver). Parts off the screen are cropped.
+    virtual void write_rects(int hor, int ver, const uint16_t *data,
+                             int len) = 0;
+
+    // Write the opaque pixels of a color-keyed sprite (see sprite_image.h),
+    // leaving what's under the transparent ones alone. Parts off the screen
+    // are cropped.
+    virtual void write_sprite(int hor, int ver, const SpriteImageHdr *sprite,
+                              HAlign align = HAlign::Left) = 0;
+
+    // write run-length compressed image to screen
+    virtual void write(int hor, int ver, const RleImageHdr *image,
+                       HAlign align = HAlign::Left) = 0;
+
+    // write palette-indexed image to screen
+    // 'palette' has (1 << bpp) entries
+    virtual void write(int hor, int ver, const IndexedImageHdr *image,
+                       const Pixel565 *palette, HAlign align = HAlign::Left) = 0;
+
+    // write alpha-mask image to screen, blending from 'bg' (no coverage) to
+    // 'fg' (full coverage)
+    virtual void write_mask(int hor, int ver, const MaskImageHdr *mask,
+                            const Color fg, const Color bg,
+                            HAlign align = HAlign::Left) = 0;
+
     // write number to screen using pre-rendered digit images
     virtual void write(int hor, int ver, int num, const PixelImageHdr *dig[10],
                        HAlign align = HAlign::Left, //
@@ -148,23 +239,100 @@ public:
                                 const Color bg,
                                 Quadrant quadrant = Quadrant::All);
 
+    // print one glyph to screen
+    // (hor, ver) is the top left pixel of the character box, which is
+    // g.x_adv wide and y_adv high, times 'scale' (each glyph pixel is drawn
+    // as a scale x scale block).
+    virtual void print_glyph(int hor, int ver, const Glyph &g, int y_adv,
+                             const Color fg, const Color bg,
+                             int scale = 1) = 0;
+
     // print character to screen
+    // The default handles alignment and calls print_glyph. With 'scale' > 1
+    // the character is that many times the font's size (e.g. 3 for giant
+    // digits from roboto_48), by pixel replication.
     virtual void print(int hor, int ver, char ch, const Font &font, //
                        const Color fg, const Color bg,
-                       HAlign align = HAlign::Left) = 0;
+                       HAlign align = HAlign::Left, int scale = 1);
+
+    virtual void print(int hor, int ver, char ch, const FontRange &font, //
+                       const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1);
+
+    virtual void print(int hor, int ver, char ch, const FontSparse &font, //
+                       const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1);
 
     // print string to screen
-    // The default just iterates through char-by-char; one might want to
-    // override this if too many glyphs extend outside their bounding box.
+    // The string is UTF-8, and 'scale' is as for a character. The default
+    // just iterates through char-by-char; one might want to override this if
+    // too many glyphs extend outside their bounding box (Tft does, when a
+    // line buffer is attached).
     virtual void print(int hor, int ver, const char *str, const Font &font, //
                        const Color fg, const Color bg,
-                       HAlign align = HAlign::Left);
+                       HAlign align = HAlign::Left, int scale = 1);
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontRange &font, //
+                       const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1);
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontSparse &font, //
+                       const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1);
+
+    // Print string to screen rotated and/or mirrored, e.g. Cw90 for text
+    // running down the screen. (hor, ver) is the top left of the string's
+    // box on the screen. As for unrotated strings, characters not entirely
+    // on the screen are not printed.
+    virtual void print(int hor, int ver, const char *str, const Font &font,
+                       const Color fg, const Color bg, Orient orient,
+                       int scale = 1) = 0;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontRange &font, const Color fg, const Color bg,
+                       Orient orient, int scale = 1) = 0;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontSparse &font, const Color fg, const Color bg,
+                       Orient orient, int scale = 1) = 0;
+
+    // print string to screen from pre-rendered character boxes (the colors
+    // are the atlas's)
+    virtual void print(int hor, int ver, const char *str,
+                       const FontAtlas &atlas, HAlign align = HAlign::Left) = 0;
 
     virtual void wait_idle()
     {
         // default does nothing
     }
 
+    // whether all drawing has finished (nothing queued or being sent)
+    virtual bool idle()
+    {
+        return true;
+    }
+
+    // Record rendering events to 'trace' (nullptr to stop)
+    virtual void trace(Trace *)
+    {
+        // default does nothing
+    }
+
+    // Keep rendered characters in 'cache' (nullptr to stop)
+    virtual void glyph_cache(GlyphCache *)
+    {
+        // default does nothing
+    }
+
+    // Print whole strings into one window, laying them out in 'arena'
+    // (nullptr to stop); see Tft::line_buffer
+    virtual void line_buffer(void *, int)
+    {
+        // default does nothing
+    }
+
 protected:
 
     const int _phys_wid;
@@ -178,6 +346,15 @@ protected:
 
     Rotation _rotation;
 
+    // The print methods for each font type are thin wrappers around these.
+    template <typename FONT>
+    void print_char(int hor, int ver, uint32_t ch, const FONT &font, //
+                    const Color fg, const Color bg, HAlign align, int scale);
+
+    template <typename FONT>
+    void print_str(int hor, int ver, const char *str, const FONT &font, //
+                   const Color fg, const Color bg, HAlign align, int scale);
+
     bool q1(Quadrant q)
     {
         return static_cast<int>(q) & static_cast<int>(Quadrant::LowerRight);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+
+#include "font.h"
+#include "pixel_565.h"
+
+// Cache of rendered character cells.
+//
+// Printing a character blends every pixel of its cell from the glyph's
+// coverage, but a UI prints the same few characters in the same colors over
+// and over. With a cache attached (Tft::glyph_cache), a character is blended
+// into a cell the first time it is printed, and every print of it after that
+// is just an async Copy op from the cell: no blending, and no waiting for
+// earlier ops to finish.
+//
+// The cache lives in an arena supplied by the caller, divided into equal
+// cells of up to 'cell_pixels' pixels each (the largest character box that
+// will be cached, e.g. font.max_width() * font.height()). Characters with
+// bigger boxes are printed the normal way. When all cells are in use, the
+// least recently used one is reused.
+//
+// A cell is identified by everything that determines its pixels: the glyph
+// (which identifies the font and character), the font height, and the two
+// colors, at their full 8 bits per channel since the blend is done at
+// that precision (two colors with the same 565 value can blend
+// differently). Fonts sharing glyph data (e.g. a font and its font_kern() copy)
+// share cells.
+//
+// The hit/miss/eviction counters are for sizing the arena: mostly misses
+// with many evictions means it is too small.
+//
+// GlyphCache has no pico dependencies. It is not interrupt-safe; it is only
+// used from the main context.
+
+class GlyphCache
+{
+
+public:
+
+    struct Key {
+        const uint8_t *data;
+        GlyphFormat format;
+        int8_t w, h;
+        int8_t x_off, y_off;
+        int8_t x_adv, y_adv;
+        uint32_t fg, bg; // 0xrrggbb, the colors the cell is blended from
+
+        bool operator==(const Key &k) const
+        {
+            return data == k.data && format == k.format && w == k.w &&
+                   h == k.h && x_off == k.x_off && y_off == k.y_off &&
+                   x_adv == k.x_adv && y_adv == k.y_adv && fg == k.fg &&
+                   bg == k.bg;
+        }
+    };
+
+    // 'arena' must be 4-byte aligned
+    GlyphCache(void *arena, int arena_bytes, int cell_pixels);
+
+    // Find the cell for 'key'. On a hit, 'hit' is set and the cell has the
+    // character's pixels. On a miss, the least recently used cell is
+    // assigned to 'key' and the caller must fill it in. Returns -1 if the
+    // character box is bigger than a cell.
+    int lookup(const Key &key, bool &hit);
+
+    Pixel565 *pixels(int cell)
+    {
+        return _pixels + cell * _cell_pixels;
+    }
+
+    // Tft records here the op that last sent the cell, so it doesn't
+    // overwrite the cell before that op has finished.
+    uint32_t op_seq(int cell) const
+    {
+        return _entries[cell].op_seq;
+    }
+
+    void op_seq(int cell, uint32_t seq)
+    {
+        _entries[cell].op_seq = seq;
+    }
+
+    // forget everything (counters too)
+    void reset();
+
+    int cells() const
+    {
+        return _cells;
+    }
+
+    int cell_pixels() const
+    {
+        return _cell_pixels;
+    }
+
+    uint32_t hits() const
+    {
+        return _hits;
+    }
+
+    uint32_t misses() const
+    {
+        return _misses;
+    }
+
+    uint32_t evictions() const
+    {
+        return _evictions;
+    }
+
+private:
+
+    struct Entry {
+        Key key;
+        uint32_t used;   // _tick when last used, 0 if empty
+        uint32_t op_seq; // op that last sent this cell
+    };
+
+    Entry *_entries;
+    Pixel565 *_pixels;
+    int _cells;
+    int _cell_pixels;
+
+    uint32_t _tick;
+
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _evictions;
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "font.h"
+#include "pixel_565.h"
+
+// Rendering character boxes, shared by Tft (at runtime) and label_img (at
+// compile time).
+//
+// Blending a coverage value with Color::interpolate takes three divisions,
+// but for a given pair of colors there are only 256 possible results.
+// BlendLut computes them once; rendering is then a table lookup per glyph
+// pixel. Margins around the glyph (usually most of the box) are filled with
+// background directly, and glyph coverage is only read for rows that have
+// glyph in them.
+
+template <typename PIXEL = Pixel565>
+class BlendLut
+{
+
+public:
+
+    constexpr BlendLut() :
+        _pix{}
+    {
+    }
+
+    constexpr BlendLut(Color bg, Color fg) :
+        _pix{}
+    {
+        set(bg, fg);
+    }
+
+    constexpr void set(Color bg, Color fg)
+    {
+        for (int i = 0; i < 256; i++)
+            _pix[i] = Color::interpolate(uint8_t(i), bg, fg);
+    }
+
+    constexpr PIXEL operator[](uint8_t cov) const
+    {
+        return _pix[cov];
+    }
+
+    constexpr const PIXEL *table() const
+    {
+        return _pix;
+    }
+
+private:
+
+    PIXEL _pix[256];
+};
+
+// Render a character box one row at a time, top to bottom:
+//
+//   GlyphRaster<Pixel565> raster(g, lut);
+//   for (int row = 0; row < y_adv; row++)
+//       raster.row(dst_row); // g.x_adv pixels
+//
+// Parts of the glyph outside the box are cropped.
+//
+// For scaled text, row(dst, scale) writes each pixel 'scale' times (nearest
+// neighbor), g.x_adv * scale pixels in all; the caller repeats each row
+// 'scale' times (e.g. by copying it), since the glyph is read only once.
+template <typename PIXEL = Pixel565>
+class GlyphRaster
+{
+
+public:
+
+    constexpr GlyphRaster(const Glyph &g, const BlendLut<PIXEL> &lut) :
+        _g(g),
+        _lut(lut),
+        _gs(g.reader()),
+        _row(0),
+        _col_beg(0),
+        _col_end(0),
+        _skip_left(0),
+        _skip_right(0)
+    {
+        // glyph columns inside the box are [_col_beg, _col_end)
+        _col_beg = (g.x_off < 0) ? 0 : g.x_off;
+        _col_end = g.x_off + g.w;
+        if (_col_end > g.x_adv)
+            _col_end = g.x_adv;
+        if (_col_end < _col_beg)
+            _col_end = _col_beg; // glyph entirely left or right of box
+        _skip_left = (g.x_off < 0) ? -g.x_off : 0;
+        if (_skip_left > g.w)
+            _skip_left = g.w;
+        _skip_right = g.w - _skip_left - (_col_end - _col_beg);
+
+        // glyph rows above the box are cropped
+        if (g.y_off < 0)
+            _gs.skip(-g.y_off * g.w);
+    }
+
+    // render next row of the box into dst[0..x_adv * scale)
+    constexpr void row(PIXEL *dst, int scale = 1)
+    {
+        render<false>(dst, scale);
+    }
+
+    // Next row of the box as coverage in dst[0..x_adv), 0 in the margins.
+    // This is for drawing on an image that already has the background,
+    // where only nonzero coverage is drawn (a kerned box can overlap the
+    // previous one).
+    constexpr void row_cov(uint8_t *dst)
+    {
+        render<true>(dst, 1);
+    }
+
+private:
+
+    const Glyph _g;
+    const BlendLut<PIXEL> &_lut;
+    GlyphReader _gs;
+    int _row;        // next row of box
+    int _col_beg;    // first box column with glyph
+    int _col_end;    // box column after last with glyph
+    int _skip_left;  // glyph columns left of box
+    int _skip_right; // glyph columns right of box
+
+    // with 'cov', dst gets coverage (and scale must be 1)
+    template <bool cov, typename T>
+    constexpr void render(T *dst, int scale)
+    {
+        const int row = _row++;
+        T bg{};
+        if constexpr (!cov)
+            bg = _lut[0];
+
+        if (row < _g.y_off || row >= (_g.y_off + _g.h)) {
+            // no glyph in this row
+            fill(dst, 0, _g.x_adv * scale, bg);
+            return;
+        }
+
+        fill(dst, 0, _col_beg * scale, bg);
+
+        _gs.skip(_skip_left);
+        if constexpr (cov) {
+            _gs.read(dst + _col_beg, _col_end - _col_beg);
+        } else if (scale == 1) {
+            _gs.read(dst + _col_beg, _col_end - _col_beg, _lut.table());
+        } else {
+            for (int col = _col_beg; col < _col_end; col++)
+                fill(dst, col * scale, (col + 1) * scale, _lut[_gs.next()]);
+        }
+        _gs.skip(_skip_right);
+
+        fill(dst, _col_end * scale, _g.x_adv * scale, bg);
+    }
+
+    template <typename T>
+    static constexpr void fill(T *dst, int beg, int end, T val)
+    {
+        for (int i = beg; i < end; i++)
+            dst[i] = val;
+    }
+};
+
+// Put the 'ov' columns where b's character box overlaps the end of a's (see
+// glyph_boxes), with each pixel's coverage the greater of the two glyphs'.
+// They're put as Gray8 glyphs on the stack, a band of rows at a time:
+// put(y, g, rows) for a g.x_adv x rows box 'y' rows down.
+template <typename PUT>
+void glyph_overlap(const Glyph &a, const Glyph &b, int ov, int y_adv, PUT put)
+{
+    static constexpr BlendLut<uint8_t> no_lut{}; // row_cov doesn't use it
+    GlyphRaster<uint8_t> ra(a, no_lut);
+    GlyphRaster<uint8_t> rb(b, no_lut);
+
+    uint8_t row_a[128]; // x_adv is int8_t
+    uint8_t row_b[128];
+    uint8_t band[256];
+    int band_rows = int(sizeof(band)) / ov;
+    if (band_rows > 127)
+        band_rows = 127; // Glyph::h is int8_t
+
+    int y = 0; // first row in band
+    int n = 0; // rows in band
+    for (int row = 0; row < y_adv; row++) {
+        ra.row_cov(row_a);
+        rb.row_cov(row_b);
+        const uint8_t *cov_a = row_a + a.x_adv - ov;
+        uint8_t *dst = band + n * ov;
+        for (int i = 0; i < ov; i++)
+            dst[i] = (cov_a[i] > row_b[i]) ? cov_a[i] : row_b[i];
+        if (++n == band_rows || row == (y_adv - 1)) {
+            const Glyph g{band,      GlyphFormat::Gray8, int8_t(ov), int8_t(n),
+                          int8_t(0), int8_t(0),          int8_t(ov)};
+            put(y, g, n);
+            y += n;
+            n = 0;
+        }
+    }
+}
+
+// Lay out UTF-8 string 's' for printing a character box at a time, with no
+// buffer to draw the string in (Framebuffer::print, and Tft's rotated print
+// without a line buffer): put(x, y, g, y_adv) for a g.x_adv x y_adv box with
+// its top left at (x, y) in the string's box, unscaled.
+//
+// Boxes step as font.width(s) measures. Negative kerning pulls a box over
+// the end of the one before ("AV", "To"), and printing both whole would
+// paint the second's background over the first character. So the shared
+// columns are put on their own, drawn from both glyphs (glyph_overlap), and
+// the boxes either side are put without them.
+template <typename FONT, typename PUT>
+void glyph_boxes(const char *s, const FONT &font, PUT put)
+{
+    const int y_adv = font.height();
+
+    int x = 0;
+    int ov_l = 0; // columns at the start of c's box already put
+    uint32_t c = (*s != '\0') ? utf8_next(s) : 0;
+    while (c != 0) {
+        const uint32_t n = (*s != '\0') ? utf8_next(s) : 0;
+        const int step = font.width(c) + ((n != 0) ? font.kerning(c, n) : 0);
+
+        int ov_r = 0; // columns at the end of c's box shared with n's
+        if (font.printable(c)) {
+            const Glyph g = font.glyph(c);
+            if (n != 0 && font.printable(n)) {
+                ov_r = g.x_adv - step;
+                // only when n's box starts inside what's left of c's, and
+                // doesn't end inside it; otherwise they're put whole
+                if (ov_r < 0 || ov_r > (g.x_adv - ov_l) ||
+                    ov_r > font.glyph(n).x_adv)
+                    ov_r = 0;
+            }
+            Glyph mid = g;
+            mid.x_off = int8_t(g.x_off - ov_l);
+            mid.x_adv = int8_t(g.x_adv - ov_l - ov_r);
+            if (mid.x_adv > 0)
+                put(x + ov_l, 0, mid, y_adv);
+            if (ov_r > 0)
+                glyph_overlap(g, font.glyph(n), ov_r, y_adv,
+                              [&](int y, const Glyph &o, int rows) {
+                                  put(x + step, y, o, rows);
+                              });
+        }
+
+        x += step;
+        ov_l = ov_r;
+        c = n;
+    }
+}
@@ -22,5 +22,5 @@ public:
 
 private:
 
-    virtual uint8_t madctl() const;
+    virtual uint8_t madctl(Rotation r) const;
 };
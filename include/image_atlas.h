@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Many label images packed into one.
+//
+// A screen's worth of labels made with label_img is many separate flash
+// objects, each with its own header and padding, scattered around flash.
+// An ImageAtlas renders a list of labels at compile time into one image,
+// packed in shelves (rows of labels, tallest first), and hands back a
+// PixelImageView for each, which is written like any view:
+//
+//   static constexpr AtlasLabel labels[] = {
+//       {"HOME", 64, 32, fg, bg},
+//       {"HOME", 64, 32, fg, bg, 1, fg},
+//       ...
+//   };
+//   static constexpr int n = sizeof(labels) / sizeof(labels[0]);
+//   static constexpr int a_wid = 256;
+//   static constexpr int a_hgt = image_atlas_height(labels, n, a_wid);
+//   static constexpr ImageAtlas<n, a_wid, a_hgt> atlas =
+//       image_atlas<n, a_wid, a_hgt>(labels, font);
+//
+//   fb.write(hor, ver, atlas.view(0));
+//
+// Keeping a screen's assets together in flash also means they share XIP
+// cache lines rather than each dragging in its neighbors' unrelated data.
+//
+// As with FontAtlas, building one takes more than one step since the size
+// must be known to declare its type. All labels in an atlas use one font;
+// index the labels with an enum to give the handles names.
+
+// One label, as the arguments to label_img
+struct AtlasLabel {
+    const char *text;
+    int wid, hgt;
+    Color text_clr;
+    Color bgnd_clr;
+    int bord_thk = 0;
+    Color bord_clr = Color::none();
+};
+
+struct AtlasRect {
+    int16_t x, y;
+};
+
+// Shelf packing: labels are taken tallest first and placed left to right,
+// starting a new shelf below when the next won't fit in 'wid'. Puts each
+// label's position in 'pos' and returns the height used.
+static constexpr int image_atlas_pack(const AtlasLabel *labels, int n,
+                                      int wid, AtlasRect *pos)
+{
+    assert(n <= 256);
+
+    // order[] is label indexes, tallest first (insertion sort, stable)
+    int order[256]{};
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        while (j > 0 && labels[order[j - 1]].hgt < labels[i].hgt) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int x = 0;
+    int y = 0;
+    int shelf_hgt = 0;
+    for (int k = 0; k < n; k++) {
+        const AtlasLabel &l = labels[order[k]];
+        if ((x + l.wid) > wid) {
+            // next shelf
+            x = 0;
+            y += shelf_hgt;
+            shelf_hgt = 0;
+        }
+        pos[order[k]] = AtlasRect{int16_t(x), int16_t(y)};
+        x += l.wid;
+        if (l.hgt > shelf_hgt)
+            shelf_hgt = l.hgt;
+    }
+    return y + shelf_hgt;
+}
+
+// height of an atlas 'wid' wide holding 'labels'
+static constexpr int image_atlas_height(const AtlasLabel *labels, int n,
+                                        int wid)
+{
+    AtlasRect pos[256]{};
+    return image_atlas_pack(labels, n, wid, pos);
+}
+
+template <int n, int wid, int hgt>
+struct ImageAtlas {
+    static_assert(0 < n && n <= 256, "ImageAtlas: 1 to 256 labels");
+    PixelImage<Pixel565, wid, hgt> img;
+    AtlasRect pos[n];
+    int16_t w[n], h[n];
+
+    constexpr PixelImageView view(int i) const
+    {
+        return PixelImageView{&img.hdr, pos[i].x, pos[i].y, w[i], h[i]};
+    }
+};
+
+template <int n, int wid, int hgt, typename FONT>
+static constexpr ImageAtlas<n, wid, hgt>
+image_atlas(const AtlasLabel *labels, const FONT &font)
+{
+    ImageAtlas<n, wid, hgt> atlas{};
+    const int used = image_atlas_pack(labels, n, wid, atlas.pos);
+    assert(used == hgt);
+    (void)used;
+
+    for (int i = 0; i < n; i++) {
+        const AtlasLabel &l = labels[i];
+        assert(l.wid <= wid);
+        atlas.w[i] = int16_t(l.wid);
+        atlas.h[i] = int16_t(l.hgt);
+        Pixel565 *pixels =
+            &atlas.img.pixels[atlas.pos[i].y * wid + atlas.pos[i].x];
+        // outline and background, as label_img
+        for (int row = 0; row < l.hgt; row++) {
+            for (int col = 0; col < l.wid; col++) {
+                if (row < l.bord_thk || row >= (l.hgt - l.bord_thk) || //
+                    col < l.bord_thk || col >= (l.wid - l.bord_thk)) {
+                    pixels[row * wid + col] = l.bord_clr;
+                } else {
+                    pixels[row * wid + col] = l.bgnd_clr;
+                }
+            }
+        }
+        label_text(pixels, l.wid, l.hgt, wid, l.text, font, l.text_clr,
+                   l.bgnd_clr, 1);
+    }
+    return atlas;
+}
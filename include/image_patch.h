@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Changes from one image to another, as rectangles of new pixels.
+//
+// A widget with two states (a nav button active and inactive) is usually two
+// full images that differ in only a few pixels, e.g. a 1 px border. Writing
+// the other image re-sends all of it. An ImagePatch holds only the changed
+// rectangles and their pixels, so Framebuffer::write_patch applies the
+// change with one async Copy op per rectangle. For a bordered button that's
+// four thin rectangles, 5-15% of the pixels.
+//
+// The data is a stream of 16-bit words, one record per rectangle:
+//
+//   x, y, wid, hgt, p1, p2, ... p(wid * hgt)
+//
+// with the rectangle's pixels in row-major order. Pixel values are
+// Pixel565::value(), i.e. already in the form sent to the display, so the
+// pixels are copied straight from flash.
+//
+// Like an RleImage, creating one at compile time takes two steps, since the
+// size must be known to declare its type:
+//
+//   static constexpr int len = image_patch_len(inactive, active);
+//   static constexpr ImagePatch<wid, hgt, len> activate =
+//       image_patch<len>(inactive, active);
+//
+// A patch is from one image to the other; going back needs another (with
+// the same rectangles). The images must be different.
+
+struct ImagePatchHdr {
+    int wid;
+    int hgt;
+    int len; // number of uint16_t in data
+};
+
+template <int w, int h, int n>
+struct ImagePatch {
+    ImagePatchHdr hdr{w, h, n};
+    uint16_t data[n];
+};
+
+// Changed pixels closer than this in a row are sent in one rectangle, since
+// each rectangle costs a window setup (about the time of a dozen pixels).
+static constexpr int image_patch_gap = 12;
+
+static constexpr int image_patch_rects_max = 256;
+
+struct ImagePatchRect {
+    int x, y, wid, hgt;
+};
+
+// Changed rectangles, found a row at a time: each row's changed spans
+// (close ones merged) either extend a rectangle ending on the row above
+// with the same columns, or start a new one. Returns the number of
+// rectangles put in 'rect'.
+template <int wid, int hgt>
+static constexpr int
+image_patch_rects(const PixelImage<Pixel565, wid, hgt> &from,
+                  const PixelImage<Pixel565, wid, hgt> &to,
+                  ImagePatchRect *rect)
+{
+    int n = 0;
+    for (int row = 0; row < hgt; row++) {
+        const Pixel565 *f = &from.pixels[row * wid];
+        const Pixel565 *t = &to.pixels[row * wid];
+        int col = 0;
+        while (col < wid) {
+            if (f[col].value() == t[col].value()) {
+                col++;
+                continue;
+            }
+            // span [x0, x1) of changes no more than image_patch_gap apart
+            const int x0 = col;
+            int x1 = col + 1;
+            for (col = x1; col < wid && (col - x1) < image_patch_gap; col++) {
+                if (f[col].value() != t[col].value())
+                    x1 = col + 1;
+            }
+            col = x1;
+            // extend a rectangle from the row above?
+            int r = 0;
+            while (r < n && !(rect[r].x == x0 && rect[r].wid == (x1 - x0) &&
+                              (rect[r].y + rect[r].hgt) == row))
+                r++;
+            if (r < n) {
+                rect[r].hgt++;
+            } else {
+                assert(n < image_patch_rects_max);
+                rect[n++] = ImagePatchRect{x0, row, x1 - x0, 1};
+            }
+        }
+    }
+    return n;
+}
+
+// number of uint16_t in the patch from 'from' to 'to'
+template <int wid, int hgt>
+static constexpr int
+image_patch_len(const PixelImage<Pixel565, wid, hgt> &from,
+                const PixelImage<Pixel565, wid, hgt> &to)
+{
+    ImagePatchRect rect[image_patch_rects_max]{};
+    const int n = image_patch_rects(from, to, rect);
+    assert(n > 0); // images are the same
+    int len = 0;
+    for (int r = 0; r < n; r++)
+        len += 4 + rect[r].wid * rect[r].hgt;
+    return len;
+}
+
+// patch from 'from' to 'to'; 'len' must be image_patch_len(from, to)
+template <int len, int wid, int hgt>
+static constexpr ImagePatch<wid, hgt, len>
+image_patch(const PixelImage<Pixel565, wid, hgt> &from,
+            const PixelImage<Pixel565, wid, hgt> &to)
+{
+    ImagePatchRect rect[image_patch_rects_max]{};
+    const int n = image_patch_rects(from, to, rect);
+    ImagePatch<wid, hgt, len> patch{};
+    int i = 0;
+    for (int r = 0; r < n; r++) {
+        patch.data[i++] = uint16_t(rect[r].x);
+        patch.data[i++] = uint16_t(rect[r].y);
+        patch.data[i++] = uint16_t(rect[r].wid);
+        patch.data[i++] = uint16_t(rect[r].hgt);
+        for (int y = rect[r].y; y < (rect[r].y + rect[r].hgt); y++)
+            for (int x = rect[r].x; x < (rect[r].x + rect[r].wid); x++)
+                patch.data[i++] = to.pixels[y * wid + x].value();
+    }
+    assert(i == len);
+    return patch;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "font.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Palette-indexed images.
+//
+// Most UI art uses only a few colors, so storing 16 bits per pixel wastes
+// most of the flash. An indexed image stores 1, 2, 4, or 8 bits per pixel,
+// each an index into a palette of Pixel565 supplied when the image is
+// written. Tft::write expands each row through _pix_buf and dma sends it.
+//
+// Since the palette is not part of the image, the same image can be drawn
+// in different colors (active/inactive, day/night) by passing a different
+// palette.
+//
+// Each row starts on a byte boundary. Within a byte, the leftmost pixel is
+// in the most significant bits.
+
+struct IndexedImageHdr {
+    int wid;
+    int hgt;
+    int bpp; // 1, 2, 4, or 8
+};
+
+static constexpr int indexed_row_bytes(int wid, int bpp)
+{
+    return (wid * bpp + 7) / 8;
+}
+
+template <int bpp, int w, int h>
+struct IndexedImage {
+    static_assert(bpp == 1 || bpp == 2 || bpp == 4 || bpp == 8,
+                  "IndexedImage: bpp must be 1, 2, 4, or 8");
+    IndexedImageHdr hdr{w, h, bpp};
+    uint8_t data[indexed_row_bytes(w, bpp) * h];
+};
+
+template <int bpp>
+struct Palette {
+    Pixel565 colors[1 << bpp];
+};
+
+// get/set palette index of pixel at (row, col)
+static constexpr int indexed_get(const uint8_t *data, int wid, int bpp,
+                                 int row, int col)
+{
+    const int bit = col * bpp;
+    const uint8_t b = data[row * indexed_row_bytes(wid, bpp) + bit / 8];
+    return (b >> (8 - bpp - bit % 8)) & ((1 << bpp) - 1);
+}
+
+static constexpr void indexed_set(uint8_t *data, int wid, int bpp, int row,
+                                  int col, int idx)
+{
+    const int bit = col * bpp;
+    const int shift = 8 - bpp - bit % 8;
+    uint8_t &b = data[row * indexed_row_bytes(wid, bpp) + bit / 8];
+    b = uint8_t((b & ~(((1 << bpp) - 1) << shift)) | (idx << shift));
+}
+
+// Palette that blends from bg (index 0) to fg (last index) in equal steps.
+// Used with label_idx to draw antialiased text in any pair of colors.
+template <int bpp>
+static constexpr Palette<bpp> blend_palette(Color bg, Color fg)
+{
+    constexpr int max = (1 << bpp) - 1;
+    Palette<bpp> pal{};
+    for (int i = 0; i <= max; i++)
+        pal.colors[i] = Color::interpolate(i * 255 / max, bg, fg);
+    return pal;
+}
+
+// index of palette entry nearest 'p'
+// (compares fields as laid out for 16-bit transfers; see pixel_565.h)
+static constexpr int palette_nearest(const Pixel565 *pal, int pal_len,
+                                     Pixel565 p)
+{
+    auto r = [](uint16_t v) { return int(v >> 11) & 0x1f; };
+    auto g = [](uint16_t v) { return int(v >> 5) & 0x3f; };
+    auto b = [](uint16_t v) { return int(v) & 0x1f; };
+    int best = 0;
+    int best_d = INT32_MAX;
+    for (int i = 0; i < pal_len; i++) {
+        const uint16_t v1 = pal[i].value();
+        const uint16_t v2 = p.value();
+        if (v1 == v2)
+            return i;
+        // red and blue are 5 bits, green is 6 bits
+        const int dr = (r(v1) - r(v2)) * 2;
+        const int dg = g(v1) - g(v2);
+        const int db = (b(v1) - b(v2)) * 2;
+        const int d = dr * dr + dg * dg + db * db;
+        if (d < best_d) {
+            best = i;
+            best_d = d;
+        }
+    }
+    return best;
+}
+
+// Create an indexed image from a PixelImage, mapping each pixel to the
+// nearest palette entry.
+//
+// This is intended for compile-time conversion; the source image is only
+// used at compile time so it does not end up in flash.
+template <int bpp, int wid, int hgt>
+static constexpr IndexedImage<bpp, wid, hgt>
+indexed_img(const PixelImage<Pixel565, wid, hgt> &src, const Palette<bpp> &pal)
+{
+    IndexedImage<bpp, wid, hgt> img{};
+    for (int row = 0; row < hgt; row++)
+        for (int col = 0; col < wid; col++)
+            indexed_set(img.data, wid, bpp, row, col,
+                        palette_nearest(pal.colors, 1 << bpp,
+                                        src.pixels[row * wid + col]));
+    return img;
+}
+
+// Create a boxed label as an indexed image.
+//
+// Same layout as label_img, but instead of colors, each pixel is the
+// glyph coverage quantized to an index: 0 is background, the last index is
+// text (and border). Draw it with a blend_palette() to pick the colors.
+template <int bpp, int wid, int hgt, typename FONT>
+static constexpr IndexedImage<bpp, wid, hgt> //
+label_idx(const char text[], const FONT font, int bord_thk = 0)
+{
+    constexpr int max = (1 << bpp) - 1;
+    IndexedImage<bpp, wid, hgt> img{};
+    // outline (background is index 0, already there)
+    for (int row = 0; row < hgt; row++) {
+        for (int col = 0; col < wid; col++) {
+            if (row < bord_thk || row >= (hgt - bord_thk) || //
+                col < bord_thk || col >= (wid - bord_thk))
+                indexed_set(img.data, wid, bpp, row, col, max);
+        }
+    }
+    int x_off = (wid - font.width(text)) / 2;
+    int y_off = (hgt - font.height()) / 2;
+    const char *s = text;
+    uint32_t prev = 0; // previous character, for kerning
+    while (*s != '\0') {
+        const uint32_t cp = utf8_next(s);
+        x_off += font.kerning(prev, cp);
+        prev = cp;
+        if (!font.printable(cp))
+            continue;
+        const Glyph g = font.glyph(cp);
+        GlyphReader gs = g.reader();
+        const int g_wid = g.w;
+        const int g_hgt = g.h;
+        const int ch_x_off = g.x_off;
+        const int ch_y_off = g.y_off;
+        for (int g_row = 0; g_row < g_hgt; g_row++) {
+            uint8_t gray_row[128] = {};
+            gs.read(gray_row, g_wid);
+            const int row = ch_y_off + g_row;
+            if (row < 0 || row >= font.height())
+                continue; // crop to character box
+            const int r = row + y_off;
+            if (r < 0 || r >= hgt)
+                continue; // text taller than image
+            for (int g_col = 0; g_col < g_wid; g_col++) {
+                const int col = ch_x_off + g_col;
+                if (col < 0 || col >= g.x_adv)
+                    continue;
+                const int c = col + x_off;
+                if (c < 0 || c >= wid)
+                    continue; // text wider than image
+                // round to nearest level
+                const int idx = (gray_row[g_col] * max + 127) / 255;
+                if (idx != 0) // don't erase a kerned neighbor
+                    indexed_set(img.data, wid, bpp, r, c, idx);
+            }
+        }
+        x_off += g.x_adv;
+    }
+    return img;
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "font.h"
+#include "framebuffer.h"
+#include "glyph_raster.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Runtime label that is updated in place.
+//
+// Re-making a label image with the runtime label_img refills the whole
+// background and re-blends every character, then sends the whole image,
+// even when one character changed (a 100x50 image with four digits takes
+// about 4 ms). A Label remembers the characters in its image and where they
+// are. Showing a new string re-renders only the columns spanned by the
+// character cells that changed (a different character, or the same one
+// moved), and sends just those columns (Framebuffer::write of part of an
+// image, one async Copy op).
+//
+// The layout is the same as label_img's (centered, kerned), so a Label and
+// a label_img of the same size and string look the same. The image is in
+// ram, supplied by the caller, e.g.
+//
+//   static PixelImage<Pixel565, 100, 50> img;
+//   Label<Font> lbl(fb, hor, ver, &img.hdr, roboto_32, fg, bg);
+//   lbl.show("1234");
+//   lbl.show("1235"); // one character cell re-rendered and sent
+//
+// Since the image might still be being sent from the previous show, show
+// waits for the display to be idle before changing it.
+
+template <typename FONT>
+class Label
+{
+
+public:
+
+    Label(Framebuffer &fb, int hor, int ver, PixelImageHdr *img,
+          const FONT &font, Color text_clr, Color bgnd_clr, int bord_thk = 0,
+          Color bord_clr = Color::none()) :
+        _fb(fb),
+        _hor(hor),
+        _ver(ver),
+        _img(img),
+        _pixels(reinterpret_cast<PixelImage<Pixel565, 0, 0> *>(img)->pixels),
+        _font(font),
+        _lut(bgnd_clr, text_clr),
+        _text_clr(text_clr),
+        _bgnd_clr(bgnd_clr),
+        _bord_thk(bord_thk),
+        _bord_clr(bord_clr),
+        _cell{},
+        _cells(-1),
+        _cols_sent(0)
+    {
+    }
+
+    // Show 'text' (UTF-8). Strings with more than cells_max characters are
+    // always rendered and sent in full.
+    void show(const char *text)
+    {
+        const int wid = _img->wid;
+        const int hgt = _img->hgt;
+
+        Cell cell[cells_max];
+        const int cells = layout(text, cell);
+
+        if (cells < 0 || _cells < 0) {
+            // everything
+            _fb.wait_idle();
+            fill(0, wid, 0, hgt);
+            if (cells < 0)
+                label_text(_pixels, wid, hgt, wid, text, _font, _text_clr,
+                           _bgnd_clr, 1);
+            else
+                for (int i = 0; i < cells; i++)
+                    render(cell[i], 0, wid);
+            _fb.write(_hor, _ver, _img);
+            _cols_sent = wid;
+            save(cell, cells);
+            return;
+        }
+
+        // columns spanned by changed cells, before and after
+        int c0 = wid;
+        int c1 = 0;
+        const int n = (cells > _cells) ? cells : _cells;
+        for (int i = 0; i < n; i++) {
+            if (i < cells && i < _cells && cell[i].cp == _cell[i].cp &&
+                cell[i].x == _cell[i].x)
+                continue;
+            if (i < cells)
+                span(cell[i], c0, c1);
+            if (i < _cells)
+                span(_cell[i], c0, c1);
+        }
+        if (c0 < 0)
+            c0 = 0;
+        if (c1 > wid)
+            c1 = wid;
+
+        save(cell, cells);
+
+        if (c0 >= c1) {
+            _cols_sent = 0; // no change
+            return;
+        }
+
+        // rows with text
+        const int y_off = (hgt - _font.height()) / 2;
+        const int r0 = (y_off < 0) ? 0 : y_off;
+        const int r1 = ((y_off + _font.height()) > hgt)
+                           ? hgt
+                           : (y_off + _font.height());
+
+        _fb.wait_idle();
+        fill(c0, c1, r0, r1);
+        for (int i = 0; i < cells; i++)
+            render(cell[i], c0, c1);
+        _fb.write(_hor + c0, _ver + r0, _img, c0, r0, c1 - c0, r1 - r0);
+        _cols_sent = c1 - c0;
+    }
+
+    // Forget what's in the image, so the next show renders and sends all
+    // of it.
+    void invalidate()
+    {
+        _cells = -1;
+    }
+
+    // number of image columns sent by the last show (0 if nothing changed)
+    int cols_sent() const
+    {
+        return _cols_sent;
+    }
+
+    static const int cells_max = 32;
+
+private:
+
+    struct Cell {
+        uint32_t cp; // character
+        int16_t x;   // left edge of box in image
+    };
+
+    Framebuffer &_fb;
+    int _hor, _ver;
+    PixelImageHdr *_img;
+    Pixel565 *_pixels;
+    const FONT _font;
+    const BlendLut<Pixel565> _lut;
+    Color _text_clr;
+    Color _bgnd_clr;
+    int _bord_thk;
+    Color _bord_clr;
+
+    Cell _cell[cells_max]; // what's in the image
+    int _cells;            // -1 if unknown
+    int _cols_sent;
+
+    // Lay out 'text' as label_img does. Returns the number of cells, or -1
+    // if there are more than cells_max.
+    int layout(const char *text, Cell *cell) const
+    {
+        int cells = 0;
+        int x = (_img->wid - _font.width(text)) / 2;
+        uint32_t prev = 0;
+        while (*text != '\0') {
+            const uint32_t cp = utf8_next(text);
+            x += _font.kerning(prev, cp);
+            prev = cp;
+            if (!_font.printable(cp))
+                continue;
+            if (cells >= cells_max)
+                return -1;
+            cell[cells].cp = cp;
+            cell[cells].x = int16_t(x);
+            cells++;
+            x += _font.width(cp);
+        }
+        return cells;
+    }
+
+    void save(const Cell *cell, int cells)
+    {
+        // (cells -1 leaves nothing known)
+        for (int i = 0; i < cells; i++)
+            _cell[i] = cell[i];
+        _cells = cells;
+    }
+
+    // extend [c0, c1) to include cell's box
+    void span(const Cell &cell, int &c0, int &c1) const
+    {
+        if (cell.x < c0)
+            c0 = cell.x;
+        if ((cell.x + _font.width(cell.cp)) > c1)
+            c1 = cell.x + _font.width(cell.cp);
+    }
+
+    // border and background, columns [c0, c1) of rows [r0, r1)
+    void fill(int c0, int c1, int r0, int r1)
+    {
+        const int wid = _img->wid;
+        const int hgt = _img->hgt;
+        const Pixel565 bord = _bord_clr;
+        const Pixel565 bgnd = _bgnd_clr;
+        for (int row = r0; row < r1; row++) {
+            const bool bord_row =
+                row < _bord_thk || row >= (hgt - _bord_thk);
+            Pixel565 *dst = _pixels + row * wid;
+            for (int col = c0; col < c1; col++) {
+                if (bord_row || col < _bord_thk || col >= (wid - _bord_thk))
+                    dst[col] = bord;
+                else
+                    dst[col] = bgnd;
+            }
+        }
+    }
+
+    // glyph pixels of 'cell' in columns [c0, c1)
+    void render(const Cell &cell, int c0, int c1)
+    {
+        const int wid = _img->wid;
+        const int hgt = _img->hgt;
+        const int y_off = (hgt - _font.height()) / 2;
+        const Glyph g = _font.glyph(cell.cp);
+        GlyphRaster<Pixel565> raster(g, _lut);
+        for (int row = 0; row < _font.height(); row++) {
+            uint8_t cov[128]; // x_adv is int8_t
+            raster.row_cov(cov);
+            const int y = y_off + row;
+            if (y < 0 || y >= hgt)
+                continue;
+            Pixel565 *dst = _pixels + y * wid;
+            for (int col = 0; col < g.x_adv; col++) {
+                const int x = cell.x + col;
+                if (cov[col] != 0 && x >= c0 && x < c1)
+                    dst[x] = _lut[cov[col]];
+            }
+        }
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "font.h"
+#include "font_symbol.h"
+#include "indexed_image.h"
+
+// Alpha-mask images, for icons drawn in any colors.
+//
+// Each pixel is a coverage value, like a glyph's: 0 is background, the
+// maximum is foreground, and in between is a blend. The colors are given
+// when the mask is written, so one icon in flash serves every theme color
+// (and active/inactive, day/night). Tft::write_mask blends each row through
+// the same lookup table used for text into _pix_buf, and dma sends it.
+//
+// Coverage is 8 bits (A8), or 4 bits (A4) at half the flash, rounded to 16
+// levels, which is usually indistinguishable for small icons. Rows are laid
+// out as an IndexedImage's: each row starts on a byte boundary, and within
+// a byte the leftmost pixel is in the most significant bits.
+//
+// Masks are made at compile time, from a coverage array (e.g. SymbolData,
+// see font_symbol.h) or from a font character:
+//
+//   static constexpr SymbolData<16, 10> arrow_cov =
+//       symbol_data<16, 10>(Symbol::ArrowRight);
+//   static constexpr MaskImage<4, 16, 10> arrow = mask_img<4>(arrow_cov);
+//
+//   fb.write_mask(hor, ver, &arrow.hdr, fg, bg);
+
+struct MaskImageHdr {
+    int wid;
+    int hgt;
+    int bpp; // 4 or 8
+};
+
+template <int bpp, int w, int h>
+struct MaskImage {
+    static_assert(bpp == 4 || bpp == 8, "MaskImage: bpp must be 4 or 8");
+    MaskImageHdr hdr{w, h, bpp};
+    uint8_t data[indexed_row_bytes(w, bpp) * h];
+};
+
+// set coverage of pixel at (row, col), rounding to the mask's levels
+template <int bpp>
+static constexpr void mask_set(uint8_t *data, int wid, int row, int col,
+                               uint8_t cov)
+{
+    constexpr int max = (1 << bpp) - 1;
+    indexed_set(data, wid, bpp, row, col, (cov * max + 127) / 255);
+}
+
+// Create a mask from 'cov', wid x hgt coverage values, row-major.
+template <int bpp, int wid, int hgt>
+static constexpr MaskImage<bpp, wid, hgt> mask_img(const uint8_t *cov)
+{
+    MaskImage<bpp, wid, hgt> img{};
+    for (int row = 0; row < hgt; row++)
+        for (int col = 0; col < wid; col++)
+            mask_set<bpp>(img.data, wid, row, col, cov[row * wid + col]);
+    return img;
+}
+
+// Create a mask from a symbol (see font_symbol.h).
+template <int bpp, int wid, int hgt>
+static constexpr MaskImage<bpp, wid, hgt>
+mask_img(const SymbolData<wid, hgt> &sym)
+{
+    return mask_img<bpp, wid, hgt>(sym.data);
+}
+
+// Create a mask of one character, centered in a wid x hgt box. The
+// character box must fit.
+template <int bpp, int wid, int hgt, typename FONT>
+static constexpr MaskImage<bpp, wid, hgt> mask_char(uint32_t cp,
+                                                    const FONT &font)
+{
+    MaskImage<bpp, wid, hgt> img{};
+    const Glyph g = font.glyph(cp);
+    const int x_off = (wid - g.x_adv) / 2 + g.x_off;
+    const int y_off = (hgt - font.height()) / 2 + g.y_off;
+    assert(g.x_adv <= wid && font.height() <= hgt);
+    GlyphReader gs = g.reader();
+    for (int g_row = 0; g_row < g.h; g_row++) {
+        uint8_t gray_row[128] = {};
+        gs.read(gray_row, g.w);
+        const int row = y_off + g_row;
+        if (row < 0 || row >= hgt)
+            continue;
+        for (int g_col = 0; g_col < g.w; g_col++) {
+            const int col = x_off + g_col;
+            if (col >= 0 && col < wid)
+                mask_set<bpp>(img.data, wid, row, col, gray_row[g_col]);
+        }
+    }
+    return img;
+}
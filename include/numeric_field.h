@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+#include "pixel_image.h"
+
+// Numeric readout from pre-rendered character images.
+//
+// Framebuffer::write(hor, ver, num, dig, ...) writes a non-negative integer
+// from digit images. A NumericField adds what a readout needs on top of
+// that: a minus sign, a decimal point (fixed-point values), ':' (times),
+// a field width with space or zero padding, and alignment within the
+// field.
+//
+// It also remembers what it last showed, so showing a new value only
+// re-sends the character cells that changed (a different character, or the
+// same one at a different position), and erases whatever the old value
+// covered that the new one doesn't. A speed updated at 50 Hz usually
+// changes one or two digits, so that's one or two async Copy ops instead of
+// the whole field.
+//
+// The images all have the same height, and would normally be made at
+// compile time with label_img (so they're in flash), all in the same
+// colors, with 'bg' their background color. Digits should all be the same
+// width (most fonts' digits are) so values don't jiggle. Make the space
+// image digit width too: with a narrower one, padding changes the field's
+// width, everything after it moves, and every cell is re-sent.
+//
+//   NumericField speed(fb, 300, 10, glyphs, 5, HAlign::Right,
+//                      NumericField::Pad::Space, 1, bg);
+//   speed.show(1234); // "123.4"
+//   speed.show(56);   // "  5.6", cells 0, 1, 2 and 4 are sent (not the '.')
+
+class NumericField
+{
+
+public:
+
+    struct Glyphs {
+        const PixelImageHdr *digit[10];
+        const PixelImageHdr *minus;
+        const PixelImageHdr *point;
+        const PixelImageHdr *colon;
+        const PixelImageHdr *space;
+    };
+
+    enum class Pad {
+        Space, // "   42", "  -42"
+        Zero,  // "00042", "-0042"
+    };
+
+    static const int chars_max = 16;
+
+    // (hor, ver) is the reference point for 'align' (see Framebuffer::HAlign),
+    // at the top of the field. 'chars' is the field width in characters,
+    // including sign and point. With 'decimals' > 0, values are fixed-point
+    // with that many digits after the point (show(1234) with 2 decimals
+    // shows "12.34").
+    NumericField(Framebuffer &fb, int hor, int ver, const Glyphs &glyphs,
+                 int chars, Framebuffer::HAlign align, Pad pad = Pad::Space,
+                 int decimals = 0, const Color bg = Color::black());
+
+    // Show a value. One that doesn't fit in the field shows as all '-'.
+    void show(int32_t value);
+
+    // Show a string of characters from the glyph set ("12:34"); others
+    // show as space. Up to chars_max characters are shown; there is no
+    // padding.
+    void show(const char *str);
+
+    // Forget what was shown, so the next show draws every cell (e.g. after
+    // the screen has been cleared).
+    void invalidate()
+    {
+        _len = -1;
+    }
+
+    // number of cells sent by the last show
+    int cells_sent() const
+    {
+        return _cells_sent;
+    }
+
+    // field height in pixels
+    int height() const
+    {
+        return _glyphs.digit[0]->hgt;
+    }
+
+private:
+
+    Framebuffer &_fb;
+    int _hor, _ver;
+    const Glyphs _glyphs;
+    int _chars;
+    Framebuffer::HAlign _align;
+    Pad _pad;
+    int _decimals;
+    Color _bg;
+
+    // what's on the screen: characters and their positions, and the
+    // horizontal extent [_left, _right)
+    char _str[chars_max];
+    int16_t _x[chars_max];
+    int _len; // -1 if unknown
+    int _left, _right;
+
+    int _cells_sent;
+
+    const PixelImageHdr *glyph(char c) const;
+
+    void draw(const char *str, int len);
+};
@@ -4,6 +4,7 @@
 
 #include "color.h"
 #include "font.h"
+#include "glyph_raster.h"
 
 // Compile-time image creation.
 
@@ -33,6 +34,77 @@ struct PixelImage {
     PIXEL pixels[w * h];
 };
 
+// A rectangle within a PixelImage (e.g. one icon of many kept in a single
+// image, or a frame of a sprite sheet). Writing one (Framebuffer::write)
+// sends just that rectangle, straight from the image.
+struct PixelImageView {
+    const PixelImageHdr *image;
+    int x, y; // top left in image
+    int wid, hgt;
+};
+
+// Cell 'n' of an image divided into 'wid' x 'hgt' cells, numbered left to
+// right, then top to bottom.
+static constexpr PixelImageView image_cell(const PixelImageHdr *image,
+                                           int wid, int hgt, int n)
+{
+    const int cols = image->wid / wid;
+    return PixelImageView{image, (n % cols) * wid, (n / cols) * hgt, wid,
+                          hgt};
+}
+
+// Render 'text' centered in a wid x hgt image that already has its
+// background, 'scale' times the font's size (used by label_img). Rows of the
+// image start 'stride' pixels apart (the image may be part of a larger
+// one).
+//
+// Each row of a character box is read as coverage once, and the glyph
+// pixels in it are drawn as 'scale' x 'scale' blocks. Only glyph pixels are
+// drawn, so a box that kerning overlaps onto the previous one doesn't erase
+// any of it. Text bigger than the image is cropped.
+template <typename PIXEL, typename FONT>
+static constexpr void label_text(PIXEL *pixels, int wid, int hgt, int stride,
+                                 const char text[], const FONT &font,
+                                 Color text_clr, Color bgnd_clr, int scale)
+{
+    const BlendLut<PIXEL> lut(bgnd_clr, text_clr);
+    int x_off = (wid - font.width(text) * scale) / 2;
+    int y_off = (hgt - font.height() * scale) / 2;
+    // for each character in the string
+    const char *s = text;
+    uint32_t prev = 0; // previous character, for kerning
+    while (*s != '\0') {
+        const uint32_t cp = utf8_next(s); // next character in string
+        x_off += font.kerning(prev, cp) * scale;
+        prev = cp;
+        if (!font.printable(cp))
+            continue;
+        const Glyph g = font.glyph(cp);
+        // render character box onto image (glyph pixels only)
+        GlyphRaster<PIXEL> raster(g, lut);
+        for (int row = 0; row < font.height(); row++) {
+            uint8_t cov[128]{}; // x_adv is int8_t
+            raster.row_cov(cov);
+            for (int col = 0; col < g.x_adv; col++) {
+                if (cov[col] == 0)
+                    continue;
+                const PIXEL pix = lut[cov[col]];
+                for (int y = 0; y < scale; y++) {
+                    const int r = (row * scale) + y + y_off;
+                    if (r < 0 || r >= hgt)
+                        continue; // text taller than image
+                    for (int x = 0; x < scale; x++) {
+                        const int c = x_off + (col * scale) + x;
+                        if (c >= 0 && c < wid)
+                            pixels[r * stride + c] = pix;
+                    }
+                }
+            }
+        }
+        x_off += g.x_adv * scale; // next character box start
+    }
+}
+
 // Create a boxed label (string surrounded by outline box).
 //
 // This is intended for compile-time creation of images to be stored in flash.
@@ -44,6 +116,7 @@ struct PixelImage {
 //  PIXEL       pixel type (e.g., Pixel565)
 //  wid         image width in pixels
 //  hgt         image height in pixels
+//  FONT        font type (Font, FontRange, or FontSparse; deduced)
 //
 // Return type template parameters:
 //  PIXEL       pixel type (e.g., Pixel565) (same as function template)
@@ -51,17 +124,20 @@ struct PixelImage {
 //  hgt         image height in pixels (same as function template)
 //
 // Function call parameters:
-//  text        string to render
+//  text        string to render (UTF-8)
 //  font        font to use
 //  text_clr    text color
 //  bord_thk    thickness of border in pixels (0 or more)
 //  bord_clr    border color
 //  bgnd_clr    background color
+//  scale       text size multiplier, e.g. 3 for digits three times the
+//              font's size (blocky, but no bigger font tables in flash)
 //
-template <typename PIXEL, int wid, int hgt>
+template <typename PIXEL, int wid, int hgt, typename FONT>
 static constexpr PixelImage<PIXEL, wid, hgt>                  //
-label_img(const char text[], const Font font, Color text_clr, //
-          Color bgnd_clr, int bord_thk = 0, Color bord_clr = Color::none())
+label_img(const char text[], const FONT font, Color text_clr, //
+          Color bgnd_clr, int bord_thk = 0, Color bord_clr = Color::none(),
+          int scale = 1)
 {
     PixelImage<PIXEL, wid, hgt> img{};
     // outline and background
@@ -75,50 +151,15 @@ label_img(const char text[], const Font font, Color text_clr, //
             }
         }
     }
-    int x_off = (wid - font.width(text)) / 2;
-    int y_off = (hgt - font.height()) / 2;
-    // for each character in the string
-    const char *s = text;
-    while (*s != '\0') {
-        const char ch = *s;
-        const int ci = int(ch);
-        const uint8_t *gs = font.data + font.info[ci].off; // grayscale
-        // width of character box
-        const int x_adv = font.info[ci].x_adv;
-        // offsets of glyph within character box
-        const int ch_x_off = font.info[ci].x_off;
-        const int ch_y_off = font.info[ci].y_off;
-        // glyph size (usually smaller than character box)
-        const int g_wid = font.info[ci].w;
-        const int g_hgt = font.info[ci].h;
-        // (row, col) covers character box
-        for (int row = 0; row < font.y_adv; row++) {
-            for (int col = 0; col < x_adv; col++) {
-                // see if the glyph covers this pixel in the character box
-                if (row >= ch_y_off && row < (ch_y_off + g_hgt) && //
-                    col >= ch_x_off && col < (ch_x_off + g_wid)) {
-                    // yes, interpolate from bgnd_clr to fg based on glyph grayscale
-                    int g_row = row - ch_y_off;
-                    int g_col = col - ch_x_off;
-                    uint8_t gray = gs[g_row * g_wid + g_col];
-                    img.pixels[(row + y_off) * wid + (x_off + col)] =
-                        Color::interpolate(gray, bgnd_clr, text_clr);
-                } else {
-                    // nope, it's background
-                    img.pixels[(row + y_off) * wid + (x_off + col)] = bgnd_clr;
-                }
-            }
-        }
-        x_off += x_adv; // next character box start
-        s++;            // next character in string
-    }
+    label_text(img.pixels, wid, hgt, wid, text, font, text_clr, bgnd_clr,
+               scale);
     return img;
 }
 
 // deprecated version with different parameter order
-template <typename PIXEL, int wid, int hgt>
+template <typename PIXEL, int wid, int hgt, typename FONT>
 static constexpr PixelImage<PIXEL, wid, hgt>                  //
-label_img(const char text[], const Font font, Color text_clr, //
+label_img(const char text[], const FONT font, Color text_clr, //
           int bord_thk, Color bord_clr, Color bgnd_clr)
 {
     PixelImage<PIXEL, wid, hgt> img{};
@@ -133,43 +174,7 @@ label_img(const char text[], const Font font, Color text_clr, //
             }
         }
     }
-    int x_off = (wid - font.width(text)) / 2;
-    int y_off = (hgt - font.height()) / 2;
-    // for each character in the string
-    const char *s = text;
-    while (*s != '\0') {
-        const char ch = *s;
-        const int ci = int(ch);
-        const uint8_t *gs = font.data + font.info[ci].off; // grayscale
-        // width of character box
-        const int x_adv = font.info[ci].x_adv;
-        // offsets of glyph within character box
-        const int ch_x_off = font.info[ci].x_off;
-        const int ch_y_off = font.info[ci].y_off;
-        // glyph size (usually smaller than character box)
-        const int g_wid = font.info[ci].w;
-        const int g_hgt = font.info[ci].h;
-        // (row, col) covers character box
-        for (int row = 0; row < font.y_adv; row++) {
-            for (int col = 0; col < x_adv; col++) {
-                // see if the glyph covers this pixel in the character box
-                if (row >= ch_y_off && row < (ch_y_off + g_hgt) && //
-                    col >= ch_x_off && col < (ch_x_off + g_wid)) {
-                    // yes, interpolate from bgnd_clr to fg based on glyph grayscale
-                    int g_row = row - ch_y_off;
-                    int g_col = col - ch_x_off;
-                    uint8_t gray = gs[g_row * g_wid + g_col];
-                    img.pixels[(row + y_off) * wid + (x_off + col)] =
-                        Color::interpolate(gray, bgnd_clr, text_clr);
-                } else {
-                    // nope, it's background
-                    img.pixels[(row + y_off) * wid + (x_off + col)] = bgnd_clr;
-                }
-            }
-        }
-        x_off += x_adv; // next character box start
-        s++;            // next character in string
-    }
+    label_text(img.pixels, wid, hgt, wid, text, font, text_clr, bgnd_clr, 1);
     return img;
 }
 
@@ -183,21 +188,24 @@ label_img(const char text[], const Font font, Color text_clr, //
 //
 // Function template parameters:
 //  PIXEL       pixel type (e.g., Pixel565)
+//  FONT        font type (Font, FontRange, or FontSparse; deduced)
 //
 // Function call parameters:
 //  img         image to modify
-//  text        string to render
+//  text        string to render (UTF-8)
 //  font        font to use
 //  text_clr    text color
 //  bord_thk    thickness of border in pixels (0 or more)
 //  bord_clr    border color
 //  bgnd_clr    background color
+//  scale       text size multiplier
 //
-template <typename PIXEL>
+template <typename PIXEL, typename FONT>
 void label_img(PixelImageHdr *img,                                 // image
-               const char text[], const Font font, Color text_clr, // label
+               const char text[], const FONT font, Color text_clr, // label
                int bord_thk, Color bord_clr,                       // border
-               Color bgnd_clr)                                     // background
+               Color bgnd_clr,                                     // background
+               int scale = 1)
 {
     PixelImage<PIXEL, 0, 0> *pimg =
         reinterpret_cast<PixelImage<PIXEL, 0, 0> *>(img);
@@ -216,41 +224,5 @@ void label_img(PixelImageHdr *img,                                 // image
             }
         }
     }
-    int x_off = (wid - font.width(text)) / 2;
-    int y_off = (hgt - font.height()) / 2;
-    // for each character in the string
-    const char *s = text;
-    while (*s != '\0') {
-        const char ch = *s;
-        const int ci = int(ch);
-        const uint8_t *gs = font.data + font.info[ci].off; // grayscale
-        // width of character box
-        const int x_adv = font.info[ci].x_adv;
-        // offsets of glyph within character box
-        const int ch_x_off = font.info[ci].x_off;
-        const int ch_y_off = font.info[ci].y_off;
-        // glyph size (usually smaller than character box)
-        const int g_wid = font.info[ci].w;
-        const int g_hgt = font.info[ci].h;
-        // (row, col) covers character box
-        for (int row = 0; row < font.y_adv; row++) {
-            for (int col = 0; col < x_adv; col++) {
-                // see if the glyph covers this pixel in the character box
-                if (row >= ch_y_off && row < (ch_y_off + g_hgt) && //
-                    col >= ch_x_off && col < (ch_x_off + g_wid)) {
-                    // yes, interpolate from bgnd_clr to fg based on glyph grayscale
-                    int g_row = row - ch_y_off;
-                    int g_col = col - ch_x_off;
-                    uint8_t gray = gs[g_row * g_wid + g_col];
-                    pixels[(row + y_off) * wid + (x_off + col)] =
-                        Color::interpolate(gray, bgnd_clr, text_clr);
-                } else {
-                    // nope, it's background
-                    pixels[(row + y_off) * wid + (x_off + col)] = bgnd_clr;
-                }
-            }
-        }
-        x_off += x_adv; // next character box start
-        s++;            // next character in string
-    }
+    label_text(pixels, wid, hgt, wid, text, font, text_clr, bgnd_clr, scale);
 }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Run-length compressed images.
+//
+// A full-screen PixelImage<Pixel565, 480, 320> is 300K of flash. UI art
+// (backgrounds, buttons, labels) is mostly long runs of a few colors, so
+// run-length coding typically shrinks it 3-10x. Tft::write decodes it into
+// _pix_buf in chunks while dma sends the previous chunk to the display.
+//
+// The compressed data is a stream of 16-bit words, pixels in row-major order
+// (runs continue from the end of one row into the next):
+//
+//   0x8000 | n, p          run: pixel value p repeated n times
+//   n, p1, p2, ... pn      literal: n pixel values
+//
+// n is 1..0x7fff. Pixel values are Pixel565::value(), i.e. already in the
+// form sent to the display.
+//
+// Creating one at compile time takes two steps, since the size of the
+// compressed data must be known to declare its type:
+//
+//   static constexpr PixelImage<Pixel565, wid, hgt> src = label_img<...>(...);
+//   static constexpr int len = rle_len(src);
+//   static constexpr RleImage<wid, hgt, len> img = rle_img<len>(src);
+//
+// 'src' is only used at compile time, so it does not end up in flash.
+
+struct RleImageHdr {
+    int wid;
+    int hgt;
+    int len; // number of uint16_t in data
+};
+
+template <int w, int h, int n>
+struct RleImage {
+    RleImageHdr hdr{w, h, n};
+    uint16_t data[n];
+};
+
+// Shortest run that is coded as a run. A run of two costs the same as two
+// literals, but breaks up a literal (costing another count word).
+static constexpr int rle_run_min = 3;
+
+static constexpr int rle_count_max = 0x7fff;
+static constexpr uint16_t rle_run_flag = 0x8000;
+
+// length of run starting at pixels[i], up to rle_count_max
+static constexpr int rle_run(const Pixel565 *pixels, int cnt, int i)
+{
+    int n = 1;
+    while ((i + n) < cnt && n < rle_count_max &&
+           pixels[i + n].value() == pixels[i].value())
+        n++;
+    return n;
+}
+
+// Walk the pixels, calling emit(word) for each word of compressed data.
+template <typename EMIT>
+static constexpr void rle_encode(const Pixel565 *pixels, int cnt, EMIT emit)
+{
+    int i = 0;
+    while (i < cnt) {
+        int run = rle_run(pixels, cnt, i);
+        if (run >= rle_run_min) {
+            emit(uint16_t(rle_run_flag | run));
+            emit(pixels[i].value());
+            i += run;
+            continue;
+        }
+        // literal: extend until a run worth coding starts
+        int lit = 0;
+        while ((i + lit) < cnt && lit < rle_count_max &&
+               rle_run(pixels, cnt, i + lit) < rle_run_min)
+            lit++;
+        emit(uint16_t(lit));
+        for (int j = 0; j < lit; j++)
+            emit(pixels[i + j].value());
+        i += lit;
+    }
+}
+
+// number of uint16_t needed to compress 'src'
+template <int wid, int hgt>
+static constexpr int rle_len(const PixelImage<Pixel565, wid, hgt> &src)
+{
+    int len = 0;
+    rle_encode(src.pixels, wid * hgt, [&len](uint16_t) { len++; });
+    return len;
+}
+
+// compress 'src'; 'len' must be rle_len(src)
+template <int len, int wid, int hgt>
+static constexpr RleImage<wid, hgt, len>
+rle_img(const PixelImage<Pixel565, wid, hgt> &src)
+{
+    RleImage<wid, hgt, len> img{};
+    int i = 0;
+    rle_encode(src.pixels, wid * hgt, [&img, &i](uint16_t word) {
+        img.data[i++] = word;
+    });
+    return img;
+}
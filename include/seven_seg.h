@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+
+// Seven-segment numerals drawn entirely with fill_rect.
+//
+// For the biggest readouts (clock, speed), a numeral drawn from a bitmap
+// font, even scaled, is a lot of pixels to render and send. A segment
+// numeral is a handful of rectangles, and on Tft each is an async Fill op:
+// nothing to render, and only a few bytes queued per segment.
+//
+// Updates only redraw the segments that change: going from 8 to 9 draws
+// one segment (e) in the 'off' color. Drawing the off segments in a dim
+// color rather than the background gives the "unlit segments" look of a
+// real display.
+//
+//       a
+//     -----
+//  f |     | b
+//    |  g  |
+//     -----
+//  e |     | c
+//    |  d  |
+//     -----
+//
+// The corner squares where segments meet are left undrawn, which keeps
+// segments apart. With 'chamfer', segment ends are pointed instead,
+// extending into the corners; this takes one fill per row (horizontal
+// segments) or per row of each point (vertical segments), so more fills.
+// With 'slant', the top of the numeral is shifted that many pixels right of
+// the bottom (italic); vertical segments are drawn as stair steps, one fill
+// per step.
+//
+// SevenSeg has no pico dependencies and no state besides its geometry; the
+// caller keeps what was last drawn at each position.
+//
+//   SevenSeg seg(96, 12, 8);
+//   uint8_t was = SevenSeg::seg_unknown;
+//   ...
+//   const uint8_t now = SevenSeg::segments('0' + digit);
+//   seg.draw(fb, hor, ver, now, was, on, off);
+//   was = now;
+
+class SevenSeg
+{
+
+public:
+
+    // segment bits
+    static constexpr uint8_t seg_a = 0x01;
+    static constexpr uint8_t seg_b = 0x02;
+    static constexpr uint8_t seg_c = 0x04;
+    static constexpr uint8_t seg_d = 0x08;
+    static constexpr uint8_t seg_e = 0x10;
+    static constexpr uint8_t seg_f = 0x20;
+    static constexpr uint8_t seg_g = 0x40;
+    static constexpr uint8_t seg_all = 0x7f;
+
+    // "previous" value that makes draw() draw every segment
+    static constexpr uint8_t seg_unknown = 0x80;
+
+    // 'hgt' numeral height, 'thk' stroke thickness, 'slant' pixels the top
+    // is shifted right, 'wid' numeral width before slant (0 for hgt/2 + thk)
+    SevenSeg(int hgt, int thk, int slant = 0, bool chamfer = false,
+             int wid = 0);
+
+    // segments lit for character 'c': '0'..'9', '-', ' ', and a few letters
+    // (A b C d E F H L o P r U); anything else is blank
+    static uint8_t segments(char c);
+
+    // Draw segments 'now' at ('hor', 'ver') (top left of the box), 'on'
+    // for lit ones and 'off' for the rest. Only segments that differ
+    // from 'was' are drawn.
+    void draw(Framebuffer &fb, int hor, int ver, uint8_t now, uint8_t was,
+              const Color on, const Color off) const;
+
+    // draw character 'c' (see segments) with all segments
+    void draw(Framebuffer &fb, int hor, int ver, char c, const Color on,
+              const Color off) const
+    {
+        draw(fb, hor, ver, segments(c), seg_unknown, on, off);
+    }
+
+    // box size, including slant
+    int width() const
+    {
+        return _wid + _slant;
+    }
+
+    int height() const
+    {
+        return _hgt;
+    }
+
+    // number of fill_rect calls to draw 'segs'
+    int fills(uint8_t segs) const;
+
+private:
+
+    int _hgt;
+    int _wid;
+    int _thk;
+    int _slant;
+    bool _chamfer;
+    int _mid; // top row of segment g
+
+    // draw or count the fills for one segment (index 0..6 for a..g)
+    int segment(Framebuffer *fb, int hor, int ver, int seg,
+                const Color c) const;
+
+    // rectangle in numeral coordinates, split into slant steps
+    int rect(Framebuffer *fb, int hor, int ver, int x, int y, int w, int h,
+             const Color c) const;
+
+    // horizontal offset of row 'y' for slant
+    int shift(int y) const
+    {
+        return (_slant * (_hgt - 1 - y)) / _hgt;
+    }
+
+    // how far a chamfered end extends into the corner, at row or column 'k'
+    // across a stroke (negative means not at all)
+    int taper(int k) const;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "pixel_565.h"
+#include "pixel_image.h"
+
+// Color-keyed sprites, stored as their opaque runs.
+//
+// Drawing an image with transparent parts over a background that isn't one
+// color (a loco icon over a track diagram) would normally mean reading the
+// display back, or keeping a copy of the screen in ram.
+//
+// A SpriteImage is made at compile time from a PixelImage in which one
+// color (the key) means transparent. Only the opaque pixels are kept, as
+// runs within each row; runs with the same columns on consecutive rows are
+// kept as one rectangle. Framebuffer::write_sprite sends each rectangle as
+// one async Copy op straight from flash, so transparent pixels are never
+// sent and whatever is under them is left alone.
+//
+// Each rectangle costs a window setup (about the time of a dozen pixels),
+// so this suits sprites whose outlines are mostly vertical edges, or that
+// are mostly transparent. A solid rectangular sprite is one op, the same as
+// writing the image.
+//
+// The data is in the same form as an ImagePatch's (see image_patch.h), a
+// stream of 16-bit words, one record per rectangle:
+//
+//   x, y, wid, hgt, p1, p2, ... p(wid * hgt)
+//
+// Creating one at compile time takes two steps, since the size must be
+// known to declare its type:
+//
+//   static constexpr PixelImage<Pixel565, wid, hgt> src = ...;
+//   static constexpr int len = sprite_len(src, key);
+//   static constexpr SpriteImage<wid, hgt, len> img =
+//       sprite_img<len>(src, key);
+
+struct SpriteImageHdr {
+    int wid;
+    int hgt;
+    int len;   // number of uint16_t in data
+    int rects; // number of rectangles in data
+};
+
+template <int w, int h, int n>
+struct SpriteImage {
+    SpriteImageHdr hdr{w, h, n, 0};
+    uint16_t data[n];
+};
+
+// Walk the opaque runs of 'src', calling rect(x, y, wid, hgt) for each
+// rectangle of them, in order of their top rows.
+template <int wid, int hgt, typename RECT>
+static constexpr void sprite_rects(const PixelImage<Pixel565, wid, hgt> &src,
+                                   Color key, RECT rect)
+{
+    const uint16_t k = Pixel565(key).value();
+    auto opaque = [&src, k](int x, int y) {
+        return src.pixels[y * wid + x].value() != k;
+    };
+    auto run_end = [&opaque](int x, int y) {
+        while (x < wid && opaque(x, y))
+            x++;
+        return x;
+    };
+    // whether [x0, x1) is an opaque run on row y
+    auto is_run = [&opaque, &run_end](int x0, int x1, int y) {
+        return (x0 == 0 || !opaque(x0 - 1, y)) && opaque(x0, y) &&
+               run_end(x0, y) == x1;
+    };
+    for (int y = 0; y < hgt; y++) {
+        int x = 0;
+        while (x < wid) {
+            if (!opaque(x, y)) {
+                x++;
+                continue;
+            }
+            const int x0 = x;
+            const int x1 = run_end(x, y);
+            x = x1;
+            if (y > 0 && is_run(x0, x1, y - 1))
+                continue; // part of the rectangle started above
+            int h = 1;
+            while ((y + h) < hgt && is_run(x0, x1, y + h))
+                h++;
+            rect(x0, y, x1 - x0, h);
+        }
+    }
+}
+
+// number of uint16_t needed for sprite of 'src', with 'key' transparent
+template <int wid, int hgt>
+static constexpr int sprite_len(const PixelImage<Pixel565, wid, hgt> &src,
+                                Color key)
+{
+    int len = 0;
+    sprite_rects(src, key, [&len](int, int, int w, int h) {
+        len += 4 + w * h;
+    });
+    assert(len > 0); // all transparent
+    return len;
+}
+
+// sprite of 'src', with 'key' transparent; 'len' must be sprite_len(src, key)
+template <int len, int wid, int hgt>
+static constexpr SpriteImage<wid, hgt, len>
+sprite_img(const PixelImage<Pixel565, wid, hgt> &src, Color key)
+{
+    SpriteImage<wid, hgt, len> img{};
+    int i = 0;
+    sprite_rects(src, key, [&src, &img, &i](int x, int y, int w, int h) {
+        img.data[i++] = uint16_t(x);
+        img.data[i++] = uint16_t(y);
+        img.data[i++] = uint16_t(w);
+        img.data[i++] = uint16_t(h);
+        for (int r = y; r < (y + h); r++)
+            for (int c = x; c < (x + w); c++)
+                img.data[i++] = src.pixels[r * wid + c].value();
+        img.hdr.rects++;
+    });
+    assert(i == len);
+    return img;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+#include "pixel_image.h"
+#include "sprite_image.h"
+
+// Moving elements over a background (a cursor, a train marker on a layout
+// map, a gauge needle).
+//
+// The displays are written, never read back, so whatever a moving element
+// covered has to come from somewhere when it moves on. A SpriteLayer knows
+// the background, either a solid color or an image (with a color around it
+// if it doesn't cover the screen), and the sprites drawn over it. Moving a
+// sprite restores what it no longer covers from the background and draws
+// it at its new position:
+//
+//   SpriteLayer layer(fb, &map.hdr, 0, 0);
+//   const int loco = layer.add(&loco_sprite.hdr);
+//   layer.move(loco, x, y); // first move just draws it
+//   ...
+//   layer.move(loco, x + 2, y);
+//
+// Restoring from an image is a part-of-image write (a Copy op with a
+// stride, straight from flash), and from a color a fill, so a move is all
+// async ops.
+//
+// Opaque sprites (PixelImage) restore only the part of the old rectangle
+// the new one doesn't cover, at most two strips for a small move; the
+// overlap is overwritten by the sprite itself. Color-keyed sprites (see
+// sprite_image.h) restore the old sprite's opaque rectangles, since the new
+// one's transparent pixels have to show the background; the transparent
+// ones were never written, so don't need it.
+//
+// Sprites are drawn in the order they were added (later ones on top). A
+// move also redraws any other sprite touching what was restored, and any
+// above the moved one that it now overlaps.
+
+class SpriteLayer
+{
+
+public:
+
+    static const int sprites_max = 8;
+
+    // solid background
+    SpriteLayer(Framebuffer &fb, const Color bg);
+
+    // background image with its top left at (bg_hor, bg_ver); outside it,
+    // the background is 'bg'
+    SpriteLayer(Framebuffer &fb, const PixelImageHdr *bg_img, int bg_hor,
+                int bg_ver, const Color bg = Color::black());
+
+    // Add a sprite, not shown until moved. Returns its handle, or -1 if
+    // there are already sprites_max.
+    int add(const PixelImageHdr *image);
+    int add(const SpriteImageHdr *sprite);
+
+    // Move a sprite's top left to (hor, ver), showing it if hidden.
+    void move(int id, int hor, int ver);
+
+    // Hide a sprite, restoring the background under it.
+    void hide(int id);
+
+    // Draw all shown sprites again (e.g. after the background has been
+    // redrawn).
+    void redraw();
+
+    // number of pixels sent by the last move or hide
+    int pixels_sent() const
+    {
+        return _pixels_sent;
+    }
+
+private:
+
+    Framebuffer &_fb;
+    const PixelImageHdr *_bg_img; // nullptr for solid
+    int _bg_hor, _bg_ver;
+    Color _bg;
+
+    struct Rect {
+        int hor, ver, wid, hgt;
+    };
+
+    struct Sprite {
+        const PixelImageHdr *image;   // opaque, or
+        const SpriteImageHdr *sprite; // color-keyed
+        int wid, hgt;
+        int hor, ver;
+        bool shown;
+    };
+
+    Sprite _sprites[sprites_max];
+    int _num_sprites;
+
+    int _pixels_sent;
+
+    int add(const PixelImageHdr *image, const SpriteImageHdr *sprite,
+            int wid, int hgt);
+
+    static Rect rect(const Sprite &s)
+    {
+        return Rect{s.hor, s.ver, s.wid, s.hgt};
+    }
+
+    static bool overlap(const Rect &a, const Rect &b);
+
+    static Rect intersect(const Rect &a, const Rect &b);
+
+    static int subtract(const Rect &a, const Rect &b, Rect *out);
+
+    // restore background in 'r' (cropped to the screen)
+    void restore(Rect r);
+
+    // restore the background under sprite 'id' at its current position,
+    // except (if opaque) what it's about to cover at 'to'
+    void uncover(int id, const Rect &to);
+
+    // draw sprite 'id', and the others it makes need it, given that the
+    // background in 'restored' was just put back
+    void draw(int id, const Rect &restored);
+
+    // draw just sprite 'id'
+    void draw_sprite(int id);
+};
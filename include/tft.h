@@ -6,12 +6,23 @@
 #include "hardware/dma.h"
 #include "hardware/gpio.h"
 #include "hardware/spi.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
 // framebuffer
 #include "color.h"
+#include "fill_pattern.h"
 #include "font.h"
+#include "font_atlas.h"
 #include "framebuffer.h"
+#include "glyph_cache.h"
+#include "glyph_raster.h"
+#include "image_patch.h"
+#include "indexed_image.h"
+#include "mask_image.h"
 #include "pixel_565.h"
+#include "rle_image.h"
+#include "sprite_image.h"
+#include "trace.h"
 // misc
 #include "spi_extra.h"
 
@@ -63,24 +74,164 @@ public:
     virtual void fill_rect(int h, int v, int wid, int hgt,
                            const Color c) override;
 
-    // Write array of pixels to screen.
+    using Framebuffer::fill_pattern;
+
+    // Fill rectangle with a repeating tile, as an async Pattern op. Like a
+    // solid fill, dma does all the work: each row is one transfer reading a
+    // row of the tile over and over (read address wrapping). Between rows
+    // the dma interrupt just restarts the channel; it doesn't wait for the
+    // spi, so the pixels keep going out.
+    virtual void fill_pattern(int h, int v, int wid, int hgt,
+                              const Pixel565 *pattern, int pat_wid,
+                              int pat_hgt) override;
+
+    using Framebuffer::write;
+
+    // Write array of pixels to screen. An image partly off the screen is
+    // cropped.
     virtual void write(int hor, int ver, const PixelImageHdr *image,
                        HAlign align = HAlign::Left) override;
 
+    // Write run-length compressed image to screen. This decodes into the
+    // working buffer, so it returns when the last chunk has been sent.
+    virtual void write(int hor, int ver, const RleImageHdr *image,
+                       HAlign align = HAlign::Left) override;
+
+    // Write palette-indexed image to screen. Each row is expanded through
+    // the working buffer, so it returns when the last row has been sent.
+    virtual void write(int hor, int ver, const IndexedImageHdr *image,
+                       const Pixel565 *palette,
+                       HAlign align = HAlign::Left) override;
+
+    // Write alpha-mask image to screen. Each row is blended through the
+    // text blend table into the working buffer, so it returns when the last
+    // row has been sent.
+    virtual void write_mask(int hor, int ver, const MaskImageHdr *mask,
+                            const Color fg, const Color bg,
+                            HAlign align = HAlign::Left) override;
+
     virtual void write(int hor, int ver, int num, const PixelImageHdr *dig[10],
                        HAlign align = HAlign::Left, //
                        int *wid = nullptr, int *hgt = nullptr) override;
 
-    // print character to screen
-    virtual void print(int h, int v, char c, const Font &font, //
+    // Write part of an image, as an async Copy op. Rows of the part are
+    // sent one dma transfer each (unless the part is full-width).
+    virtual void write(int hor, int ver, const PixelImageHdr *image, int x,
+                       int y, int wid, int hgt) override;
+
+    // Write an image scaled up. Each source row is expanded across into
+    // the working buffer once and sent 'sy' times, so it returns when the
+    // last row has been sent.
+    virtual void write_scaled(int hor, int ver, const PixelImageHdr *image,
+                              int sx, int sy) override;
+
+    // Write an image patch, one async Copy op per rectangle, straight from
+    // the patch data.
+    virtual void write_patch(int hor, int ver,
+                             const ImagePatchHdr *patch) override;
+
+    // Write rectangles, one async Copy op each, straight from 'data'.
+    virtual void write_rects(int hor, int ver, const uint16_t *data,
+                             int len) override;
+
+    // Write a sprite, one async Copy op per rectangle of opaque pixels,
+    // straight from the sprite data.
+    virtual void write_sprite(int hor, int ver, const SpriteImageHdr *sprite,
+                              HAlign align = HAlign::Left) override;
+
+    // Write an image rotated and/or mirrored, as an async Copy op that has
+    // the display controller remap its addressing (MADCTL) for the op.
+    virtual void write(int hor, int ver, const PixelImageHdr *image,
+                       Orient orient) override;
+
+    // print one glyph to screen
+    virtual void print_glyph(int hor, int ver, const Glyph &g, int y_adv,
+                             const Color fg, const Color bg,
+                             int scale = 1) override;
+
+    using Framebuffer::print;
+
+    // Print string to screen. With a line buffer attached (line_buffer),
+    // the whole string goes into one window, a row at a time across all the
+    // characters, so parts of glyphs that extend outside their character
+    // boxes are drawn over the neighboring boxes rather than cropped.
+    // Otherwise, and for strings not entirely on the screen, with more
+    // characters than the line buffer holds, or printed while a glyph cache
+    // is in use, it is printed a character at a time (Framebuffer::print).
+    virtual void print(int hor, int ver, const char *str, const Font &font,
                        const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1) override;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontRange &font, const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1) override;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontSparse &font, const Color fg, const Color bg,
+                       HAlign align = HAlign::Left, int scale = 1) override;
+
+    // Print string rotated and/or mirrored. With a line buffer it goes into
+    // one window as above, with the controller's addressing remapped while
+    // it's sent. Otherwise, and for strings not entirely on the screen or
+    // with more characters than the line buffer holds, each character box
+    // is a window of its own, and characters not entirely on the screen
+    // are skipped.
+    virtual void print(int hor, int ver, const char *str, const Font &font,
+                       const Color fg, const Color bg, Orient orient,
+                       int scale = 1) override;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontRange &font, const Color fg, const Color bg,
+                       Orient orient, int scale = 1) override;
+
+    virtual void print(int hor, int ver, const char *str,
+                       const FontSparse &font, const Color fg, const Color bg,
+                       Orient orient, int scale = 1) override;
+
+    // Print string from pre-rendered character boxes: one async Copy op per
+    // character, straight from the atlas (usually in flash). Characters not
+    // entirely on the screen are skipped.
+    virtual void print(int hor, int ver, const char *str,
+                       const FontAtlas &atlas,
                        HAlign align = HAlign::Left) override;
 
     // Wait for all pending dma operations to complete
     virtual void wait_idle() override
     {
+        if (!busy())
+            return;
+        trace_begin(Trace::Event::WaitIdle);
         while (busy())
             tight_loop_contents();
+        trace_end(Trace::Event::WaitIdle);
+    }
+
+    virtual bool idle() override
+    {
+        return !busy();
+    }
+
+    virtual void trace(Trace *t) override
+    {
+        _trace = t;
+    }
+
+    // Print whole strings in one window (see print), laying each out in
+    // 'arena' (nullptr to stop; none by default). The arena holds a row of
+    // coverage as long as the screen's longer side, then a slot for each
+    // character of the string; line_buffer_bytes() is the size for strings
+    // of up to 'chars' characters. It must be 4-byte aligned, and must not
+    // be reused while attached. Nothing is kept in it between prints.
+    virtual void line_buffer(void *arena, int arena_bytes) override;
+
+    int line_buffer_bytes(int chars) const;
+
+    // Characters found in the cache are sent with an async Copy op. The
+    // cache must not be destroyed or reset while ops might still be using
+    // it (wait_idle first).
+    virtual void glyph_cache(GlyphCache *cache) override
+    {
+        _glyph_cache = cache;
     }
 
 protected:
@@ -94,6 +245,9 @@ protected:
     static constexpr uint8_t RAMWR = 0x2c;
     //static constexpr uint8_t RGBSET = 0x2d;
     static constexpr uint8_t MADCTL = 0x36;
+    static constexpr uint8_t MADCTL_MY = 0x80; // see madctl()
+    static constexpr uint8_t MADCTL_MX = 0x40;
+    static constexpr uint8_t MADCTL_MV = 0x20;
     //static constexpr uint8_t PIXSET = 0x3a;
     //static constexpr uint8_t SETTS = 0x44;
     //static constexpr uint8_t FRMCTL = 0xb1;
@@ -136,6 +290,11 @@ protected:
     int _bk_pin;
 
     typedef PixelImage<Pixel565, 0, 0> PixelImage565;
+    typedef RleImage<0, 0, 0> RleImage0;
+    typedef IndexedImage<8, 0, 0> IndexedImage0;
+    typedef ImagePatch<0, 0, 0> ImagePatch0;
+    typedef MaskImage<8, 0, 0> MaskImage0;
+    typedef SpriteImage<0, 0, 0> SpriteImage0;
 
     uint _dma_ch;
     dma_channel_config _dma_cfg;
@@ -154,6 +313,103 @@ protected:
 
     volatile uint16_t _dma_pixel; // isr/dma shared
 
+    // Optional event recording. The trace_* methods disable interrupts so
+    // an event recorded by the dma handler can't land in the middle of one
+    // being recorded from the main context.
+    Trace *_trace;
+
+    bool _trace_dma; // a dma begin was recorded, end not yet (isr only)
+
+    GlyphCache *_glyph_cache;
+
+    // Whole-string printing, in the line buffer: the glyphs of the string
+    // being printed, each with its reader positioned at its next row, and
+    // one row of coverage across the string (unscaled). nullptr when no
+    // line buffer is attached.
+    struct LineGlyph {
+        GlyphReader gs;
+        int16_t x; // glyph's left edge, relative to string's
+        int8_t y_off;
+        int8_t w, h;
+    };
+
+    LineGlyph *_line_glyph;
+    int _line_glyph_max;
+    uint8_t *_line_cov;
+    int _line_wid_max;
+
+    // returns false if the string has to be printed a character at a time
+    template <typename FONT>
+    bool print_line(int hor, int ver, const char *str, const FONT &font,
+                    const Color fg, const Color bg, HAlign align, int scale,
+                    Orient orient = Orient::None);
+
+    // blend table for the last colors printed in (see blend_lut())
+    BlendLut<Pixel565> _blend;
+    uint32_t _blend_fg; // r, g, b of colors _blend is for
+    uint32_t _blend_bg;
+    bool _blend_valid;
+
+    const BlendLut<Pixel565> &blend_lut(const Color fg, const Color bg);
+
+    // 'c' as 0xrrggbb (as blend tables and glyph cache keys identify colors)
+    static uint32_t rgb(const Color c)
+    {
+        return (uint32_t(c.r()) << 16) | (uint32_t(c.g()) << 8) | c.b();
+    }
+
+    // render a character cell into a window set with MADCTL value 'mad'
+    void print_glyph_window(int hor, int ver, const Glyph &g, int y_adv,
+                            const Color fg, const Color bg, int scale,
+                            uint8_t mad);
+
+    // print a string oriented a character at a time (when print_line can't)
+    template <typename FONT>
+    void print_oriented(int hor, int ver, const char *str, const FONT &font,
+                        const Color fg, const Color bg, Orient orient,
+                        int scale);
+
+    // render a character cell into the cache and/or copy it from there
+    // (returns false if the character can't be cached)
+    bool print_glyph_cached(int hor, int ver, const Glyph &g, int y_adv,
+                            const Color fg, const Color bg);
+
+    // called by dma handler just before starting a transfer
+    void trace_dma_begin(uint32_t pixels)
+    {
+        if (_trace != nullptr) {
+            _trace->begin(Trace::Event::Dma, pixels);
+            _trace_dma = true;
+        }
+    }
+
+    void trace_instant(Trace::Event event, uint32_t arg = 0)
+    {
+        if (_trace != nullptr) {
+            uint32_t irq_state = save_and_disable_interrupts();
+            _trace->instant(event, arg);
+            restore_interrupts(irq_state);
+        }
+    }
+
+    void trace_begin(Trace::Event event, uint32_t arg = 0)
+    {
+        if (_trace != nullptr) {
+            uint32_t irq_state = save_and_disable_interrupts();
+            _trace->begin(event, arg);
+            restore_interrupts(irq_state);
+        }
+    }
+
+    void trace_end(Trace::Event event, uint32_t arg = 0)
+    {
+        if (_trace != nullptr) {
+            uint32_t irq_state = save_and_disable_interrupts();
+            _trace->end(event, arg);
+            restore_interrupts(irq_state);
+        }
+    }
+
     // DMA interrupts: The mux in dma_irq_mux.c handles dma interrupts.
     // Calling dma_irqn_mux_connect() connnects our handler to interrupts for
     // our channel. When we connect to the mux, we provide a void* argument
@@ -170,8 +426,33 @@ protected:
     // instance method called by static handler
     void dma_handler();
 
-    // Calculate MADCTL value for current rotation.
-    virtual uint8_t madctl() const = 0;
+    // Calculate MADCTL value for rotation 'r'.
+    virtual uint8_t madctl(Rotation r) const = 0;
+
+    // MADCTL value last sent (see madctl_set)
+    uint8_t _madctl;
+
+    // Send MADCTL value 'm' if it's not what the controller has. Every
+    // window is set with a MADCTL value (see set_window): the async ops each
+    // carry theirs (usually the rotation's), and streamed and synchronous
+    // writes use the rotation's. So whatever follows something drawn in
+    // another orientation puts it back; there's nothing to restore.
+    void madctl_set(uint8_t m)
+    {
+        if (m == _madctl)
+            return;
+        spi_set_format(_spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+        spi_write_command(MADCTL);
+        spi_write_data(m);
+        _madctl = m;
+    }
+
+    // For content 'wid' x 'hgt' drawn with 'orient' with its top left at
+    // ('hor', 'ver'), change ('hor', 'ver') to where the window goes with
+    // the controller's addressing remapped, and return the MADCTL value
+    // that does it.
+    uint8_t orient_window(Orient orient, int &hor, int &ver, int wid,
+                          int hgt) const;
 
     // Working buffer used to render character. Any size is okay, but bigger
     // means fewer transfers. Supplied to constructor.
@@ -179,6 +460,45 @@ protected:
     Pixel565 *_pix_buf;
     int _pix_buf_len; // number of pixels
 
+    // Streaming: pixels are rendered into one half of _pix_buf while dma
+    // sends the other half to the display.
+    //
+    //   stream_start(hor, ver, wid, hgt);
+    //   while (more pixels) {
+    //       Pixel565 *buf = stream_buf();
+    //       ...fill in up to stream_buf_len() pixels...
+    //       stream_send(n);
+    //   }
+    //   stream_finish();
+    //
+    // stream_resend(n) sends the last n pixels sent again, e.g. to repeat a
+    // row, without filling a half.
+    //
+    // Streamed transfers don't go through _ops[]; the dma handler sees an
+    // empty queue when each one completes and just clears busy.
+    int _stream_half; // which half of _pix_buf to fill next
+
+    void stream_start(int hor, int ver, int wid, int hgt, int madctl = -1);
+
+    int stream_buf_len() const
+    {
+        return _pix_buf_len / 2;
+    }
+
+    Pixel565 *stream_buf()
+    {
+        return _pix_buf + _stream_half * stream_buf_len();
+    }
+
+    void stream_send(int len);
+
+    void stream_resend(int len);
+
+    void stream_finish()
+    {
+        wait_idle();
+    }
+
     static constexpr bool cs_assert = false;
     static constexpr bool cs_deassert = true;
 
@@ -209,7 +529,10 @@ protected:
 
     void write(uint8_t cmd, uint8_t *buf, int buf_len);
 
-    void set_window(uint16_t hor, uint16_t ver, uint16_t wid, uint16_t hgt);
+    // set the window pixels go to, with the controller's addressing set by
+    // MADCTL value 'madctl'
+    void set_window(uint16_t hor, uint16_t ver, uint16_t wid, uint16_t hgt,
+                    uint8_t madctl);
 
     inline void spi_wait()
     {
@@ -259,18 +582,53 @@ protected:
 
     int _ops_stall_cnt; // times we had to wait for space in _ops[]
 
-    enum class AsyncOp : uint8_t { None, Fill, Copy, Max };
+    enum class AsyncOp : uint8_t { None, Fill, Copy, Pattern, Max };
 
     volatile struct {
         AsyncOp op;
+        uint8_t madctl;    // MADCTL value to send it with
         uint16_t hor, ver; // top left corner
         uint16_t wid, hgt; // rectangle to fill or copy
+        uint16_t stride;   // Copy: pixels from one row to the next
+                           // Pattern: tile width (a power of two)
+        uint16_t tile_hgt; // Pattern: tile height
         union {
             uint16_t pixel;     // pixel to fill with
-            const void *pixels; // pixels to copy from
+            const void *pixels; // pixels to copy from, or tile
         };
     } _ops[op_max]; // main/isr shared
 
+    // Ops are numbered in the order they are queued, starting at 1, so the
+    // main context can tell when a particular op has finished (e.g. before
+    // overwriting pixels it copies from).
+    uint32_t _op_seq;           // number of the last op queued (main only)
+    volatile uint32_t _op_done; // number of the last op finished (isr)
+    bool _op_active;            // an op's transfer is running (isr only)
+
+    // A Copy op whose rows aren't contiguous (stride != wid), or a Pattern
+    // op, is sent one row per dma transfer; these track the rows still to
+    // go (isr only). A Pattern op's rows come from the tile's rows in turn,
+    // back to the first after the last (_op_tile_end).
+    int _op_rows;            // rows left after the current one
+    const uint16_t *_op_src; // current row
+    int _op_stride;
+    int _op_wid;
+    const uint16_t *_op_tile_end; // Pattern only, else nullptr
+    int _op_tile_len;             // pixels in tile
+
+    bool op_finished(uint32_t seq) const
+    {
+        return int32_t(_op_done - seq) >= 0; // handles wrap
+    }
+
+    // queue an async Copy op ('stride' 0 means rows are contiguous, and
+    // 'madctl' -1 means the rotation's MADCTL value)
+    void op_copy(int hor, int ver, int wid, int hgt, const void *pixels,
+                 int stride = 0, int madctl = -1);
+
+    // queue a Copy op for each rectangle in patch or sprite data
+    void op_copy_rects(int hor, int ver, const uint16_t *data, int len);
+
     volatile int _op_next; // index of next command to execute (main/isr shared)
     volatile int _op_free; // index of next free slot (main/isr shared)
     // op_next == op_free means empty
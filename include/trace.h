@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// Rendering timeline capture.
+//
+// Tft records events at the interesting points in the rendering pipeline:
+// queueing an async op, setting the controller's window, dma start and
+// completion, rendering a glyph, and waiting for idle. write_json() dumps
+// the captured events as Chrome trace-event JSON, which loads directly in
+// chrome://tracing or ui.perfetto.dev.
+//
+// Events go in a buffer supplied by the caller. When the buffer fills up,
+// further events are dropped (and counted) rather than overwriting older
+// ones, so a capture started with reset() always shows the beginning of
+// whatever is being investigated.
+//
+// The timestamp source is a function pointer returning microseconds, so the
+// same code works on the device (time_us_32) and on a host (a steady clock,
+// or a simulated spi clock that advances with bytes sent).
+//
+// Trace has no pico dependencies. Recording is not itself interrupt-safe;
+// Tft disables interrupts around events recorded from the main context.
+
+class Trace
+{
+
+public:
+
+    enum class Event : uint8_t {
+        Enqueue,  // async op queued (instant)
+        Window,   // CASET/RASET command sequence
+        Dma,      // dma transfer, start to completion
+        Glyph,    // rendering one character (arg is box pixels)
+        WaitIdle, // waiting for queued ops to finish
+        Max
+    };
+
+    enum class Phase : uint8_t { Begin, End, Instant };
+
+    struct Record {
+        uint32_t ts; // microseconds, from clock
+        uint32_t arg;
+        Event event;
+        Phase phase;
+    };
+
+    typedef uint32_t (*Clock)();
+
+    Trace(Record *buf, int buf_len, Clock clock) :
+        _buf(buf),
+        _buf_len(buf_len),
+        _clock(clock),
+        _cnt(0),
+        _dropped(0)
+    {
+    }
+
+    void reset()
+    {
+        _cnt = 0;
+        _dropped = 0;
+    }
+
+    void begin(Event event, uint32_t arg = 0)
+    {
+        add(event, Phase::Begin, arg);
+    }
+
+    void end(Event event, uint32_t arg = 0)
+    {
+        add(event, Phase::End, arg);
+    }
+
+    void instant(Event event, uint32_t arg = 0)
+    {
+        add(event, Phase::Instant, arg);
+    }
+
+    int count() const
+    {
+        return _cnt;
+    }
+
+    int dropped() const
+    {
+        return _dropped;
+    }
+
+    const Record &operator[](int i) const
+    {
+        return _buf[i];
+    }
+
+    // Write events as Chrome trace-event JSON. Timestamps are relative to
+    // the first event recorded.
+    void write_json(FILE *f) const;
+
+    static const char *name(Event event);
+
+private:
+
+    Record *_buf;
+    int _buf_len;
+
+    Clock _clock;
+
+    volatile int _cnt;
+    volatile int _dropped;
+
+    void add(Event event, Phase phase, uint32_t arg)
+    {
+        const int i = _cnt;
+        if (i >= _buf_len) {
+            _dropped = _dropped + 1;
+            return;
+        }
+        _buf[i].ts = _clock();
+        _buf[i].arg = arg;
+        _buf[i].event = event;
+        _buf[i].phase = phase;
+        _cnt = i + 1;
+    }
+};
@@ -21,7 +21,7 @@ public:
 
 private:
 
-    virtual uint8_t madctl() const;
+    virtual uint8_t madctl(Rotation r) const;
 
     void init_colors();
 };
@@ -21,5 +21,5 @@ public:
 
 private:
 
-    virtual uint8_t madctl() const;
+    virtual uint8_t madctl(Rotation r) const;
 };
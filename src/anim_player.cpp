@@ -0,0 +1,103 @@
+#include "anim_player.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include "pico/stdlib.h"
+
+#include "animation.h"
+#include "framebuffer.h"
+
+
+AnimPlayer::AnimPlayer(Framebuffer &fb, int hor, int ver,
+                       const AnimationHdr *anim, int fps, bool loop) :
+    _fb(fb),
+    _hor(hor),
+    _ver(ver),
+    _anim(anim),
+    _data(reinterpret_cast<const Animation<0, 0, 0> *>(anim)->data),
+    _period_us((fps > 0) ? (1000000 / fps) : 0), // fps is asserted below
+    _loop(loop),
+    _playing(false),
+    _pos(0),
+    _loop_pos(0),
+    _frame(0),
+    _due(0),
+    _shown(0),
+    _dropped(0)
+{
+    assert(fps > 0);
+    assert(_anim->frames > 0);
+}
+
+
+void AnimPlayer::start()
+{
+    _pos = 0;
+    _frame = 0;
+    _shown = 0;
+    _dropped = 0;
+
+    show(); // keyframe
+    _loop_pos = _pos;
+
+    // a single frame has nothing more to show
+    _playing = _loop || _anim->frames > 1;
+
+    _due = time_us_32() + _period_us;
+}
+
+
+bool AnimPlayer::poll()
+{
+    if (!_playing)
+        return false;
+
+    if (_pos >= _anim->len)
+        return true; // looping a single frame
+
+    const uint32_t now = time_us_32();
+    if (int32_t(now - _due) < 0)
+        return true; // not yet
+
+    if (!_fb.idle())
+        return true; // last frame still going out; this one will be late
+
+    // frame times that have gone by since this one was due (none if fps
+    // wasn't valid; then frames just go as fast as they can)
+    const uint32_t missed = (_period_us > 0) ? (now - _due) / _period_us : 0;
+    _dropped += int(missed);
+    _due += (missed + 1) * _period_us;
+
+    // The records after the keyframe are the changes to frames 1, 2, ...
+    // and then back to frame 0, after which it goes round from frame 1.
+    show();
+    _frame = (_frame + 1) % _anim->frames;
+    if (_pos >= _anim->len)
+        _pos = _loop_pos;
+
+    if (!_loop && _frame == (_anim->frames - 1))
+        _playing = false;
+
+    return _playing;
+}
+
+
+void AnimPlayer::show()
+{
+    assert(_pos < _anim->len);
+
+    const int fills = _data[_pos++];
+    for (int i = 0; i < fills; i++) {
+        const uint16_t *f = _data + _pos;
+        _fb.fill_rect(_hor + f[0], _ver + f[1], f[2], f[3], anim_color(f[4]));
+        _pos += 5;
+    }
+
+    const int copy_len = _data[_pos++];
+    if (copy_len > 0)
+        _fb.write_rects(_hor, _ver, _data + _pos, copy_len);
+    _pos += copy_len;
+
+    _shown++;
+}
@@ -4,6 +4,8 @@
 #include <cstdio>
 
 #include "color.h"
+#include "font.h"
+#include "glyph_raster.h"
 
 
 void Framebuffer::line(int h1, int v1, int h2, int v2, const Color c)
@@ -102,6 +104,42 @@ void Framebuffer::fill_rect(int h, int v, int wid, int hgt, const Color c)
 }
 
 
+// write a view of an image, cropped to the screen
+void Framebuffer::write(int hor, int ver, const PixelImageView &view,
+                        HAlign align)
+{
+    if (align == HAlign::Center)
+        hor -= view.wid / 2;
+    else if (align == HAlign::Right)
+        hor -= view.wid;
+
+    int x = view.x;
+    int y = view.y;
+    int wid = view.wid;
+    int hgt = view.hgt;
+
+    if (hor < 0) {
+        x -= hor;
+        wid += hor;
+        hor = 0;
+    }
+    if (ver < 0) {
+        y -= ver;
+        hgt += ver;
+        ver = 0;
+    }
+    if ((hor + wid) > width())
+        wid = width() - hor;
+    if ((ver + hgt) > height())
+        hgt = height() - ver;
+
+    if (wid <= 0 || hgt <= 0)
+        return; // entirely off the screen
+
+    write(hor, ver, view.image, x, y, wid, hgt);
+}
+
+
 // draw circle outline
 // Midpoint Circle Algorithm (Bresenham's circle algorithm)
 // Modified from Claude's code (to add quadrant parameter)
@@ -260,13 +298,73 @@ void Framebuffer::draw_circle_aa(int h, int v, int r, const Color fg,
 }
 
 
+// print character
+template <typename FONT>
+void Framebuffer::print_char(int h, int v, uint32_t c, const FONT &font, //
+                             const Color fg, const Color bg, HAlign align,
+                             int scale)
+{
+    if (!font.printable(c) || scale < 1)
+        return;
+
+    const Glyph g = font.glyph(c);
+
+    if (align != HAlign::Left) {
+        // right-aligned or centered, back up horizontal position
+        int adjust = g.x_adv * scale; // char width in pixels
+        if (align == HAlign::Center)
+            adjust = adjust / 2;
+        h -= adjust;
+    }
+
+    print_glyph(h, v, g, font.height(), fg, bg, scale);
+}
+
+
+// A lone char is ASCII; anything else is (part of) a UTF-8 sequence, and
+// only strings can have those.
+static uint32_t char_cp(char c)
+{
+    return (uint8_t(c) < 0x80) ? uint8_t(c) : utf8_invalid;
+}
+
+
+void Framebuffer::print(int h, int v, char c, const Font &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_char(h, v, char_cp(c), font, fg, bg, align, scale);
+}
+
+
+void Framebuffer::print(int h, int v, char c, const FontRange &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_char(h, v, char_cp(c), font, fg, bg, align, scale);
+}
+
+
+void Framebuffer::print(int h, int v, char c, const FontSparse &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_char(h, v, char_cp(c), font, fg, bg, align, scale);
+}
+
+
 // print string
-void Framebuffer::print(int h, int v, const char *s, const Font &font, //
-                        const Color fg, const Color bg, HAlign align)
+template <typename FONT>
+void Framebuffer::print_str(int h, int v, const char *s, const FONT &font, //
+                            const Color fg, const Color bg, HAlign align,
+                            int scale)
 {
+    if (scale < 1)
+        return;
+
     if (align != HAlign::Left) {
         // right-aligned or centered, back up horizontal position
-        uint16_t adjust = font.width(s); // string width in pixels
+        uint16_t adjust = font.width(s) * scale; // string width in pixels
         if (align == HAlign::Center)
             adjust = adjust / 2;
         h -= adjust;
@@ -277,9 +375,36 @@ void Framebuffer::print(int h, int v, const char *s, const Font &font, //
     // through the string, so (for example) if right-align pushes it off the
     // left edge, we might still print some characters later in the string.
 
-    while (*s != '\0') {
-        char c = *s++;
-        print(h, v, c, font, fg, bg, HAlign::Left); // align already handled
-        h += font.width(c);
-    }
+    // Positions step exactly as font.width(s) measures (text_width() in
+    // font.h), so aligned strings land where expected. Where a negative
+    // kerning pulls a character over the one before, their shared columns
+    // are printed as one box, from both glyphs (see glyph_boxes).
+
+    glyph_boxes(s, font, [&](int x, int y, const Glyph &g, int y_adv) {
+        print_glyph(h + x * scale, v + y * scale, g, y_adv, fg, bg, scale);
+    });
+}
+
+
+void Framebuffer::print(int h, int v, const char *s, const Font &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_str(h, v, s, font, fg, bg, align, scale);
+}
+
+
+void Framebuffer::print(int h, int v, const char *s, const FontRange &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_str(h, v, s, font, fg, bg, align, scale);
+}
+
+
+void Framebuffer::print(int h, int v, const char *s, const FontSparse &font, //
+                        const Color fg, const Color bg, HAlign align,
+                        int scale)
+{
+    print_str(h, v, s, font, fg, bg, align, scale);
 }
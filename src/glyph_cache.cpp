@@ -0,0 +1,86 @@
+#include "glyph_cache.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include "pixel_565.h"
+
+
+GlyphCache::GlyphCache(void *arena, int arena_bytes, int cell_pixels) :
+    _entries((Entry *)arena),
+    _pixels(nullptr),
+    _cells(0),
+    _cell_pixels(cell_pixels),
+    _tick(0),
+    _hits(0),
+    _misses(0),
+    _evictions(0)
+{
+    assert((uintptr_t(arena) % 4) == 0);
+    assert(cell_pixels > 0);
+
+    // entries at the start of the arena, then the cells
+    const int cell_bytes = cell_pixels * int(sizeof(Pixel565));
+    _cells = arena_bytes / int(sizeof(Entry) + cell_bytes);
+    _pixels = (Pixel565 *)(_entries + _cells);
+
+    reset();
+}
+
+
+void GlyphCache::reset()
+{
+    for (int i = 0; i < _cells; i++) {
+        _entries[i].used = 0;
+        _entries[i].op_seq = 0;
+    }
+    _tick = 0;
+    _hits = 0;
+    _misses = 0;
+    _evictions = 0;
+}
+
+
+// The search is linear. A cache holds a few dozen cells, and comparing keys
+// costs far less than blending one character.
+int GlyphCache::lookup(const Key &key, bool &hit)
+{
+    if ((key.x_adv * key.y_adv) > _cell_pixels || _cells == 0)
+        return -1;
+
+    if (++_tick == 0)
+        _tick = 1; // 0 means empty
+
+    // an empty cell if there is one, else the least recently used
+    int victim = 0;
+    uint32_t victim_age = 0;
+    for (int i = 0; i < _cells; i++) {
+        Entry &e = _entries[i];
+        if (e.used == 0) {
+            if (victim_age != UINT32_MAX) {
+                victim = i;
+                victim_age = UINT32_MAX;
+            }
+            continue;
+        }
+        if (e.key == key) {
+            e.used = _tick;
+            _hits++;
+            hit = true;
+            return i;
+        }
+        const uint32_t age = _tick - e.used; // unsigned handles tick wrap
+        if (age > victim_age) {
+            victim = i;
+            victim_age = age;
+        }
+    }
+
+    _misses++;
+    if (_entries[victim].used != 0)
+        _evictions++;
+    _entries[victim].key = key;
+    _entries[victim].used = _tick;
+    hit = false;
+    return victim;
+}
@@ -42,7 +42,7 @@ void Hy35::init()
         wr_delay_ms | 5,
         // Now we are: sleep out, normal display, idle off
         // This is where we want to stay.
-        wr_cmd | MADCTL, madctl(),
+        wr_cmd | MADCTL, madctl(get_rotation()),
         wr_cmd | COLMOD, 0x55,  // 16 bits/pixel
         wr_cmd | CSCON, 0xc3,   // enable cmd 2 part I
         wr_cmd | CSCON, 0x96,   // enable cmd 2 part II
@@ -76,16 +76,16 @@ void Hy35::init()
 //   10 ML  vertical refresh order (always 0)
 //   08 RGB RGB-BGR order (always 1)
 //   04 MH  horizontal refresh order (always 0)
-uint8_t Hy35::madctl() const
+uint8_t Hy35::madctl(Rotation r) const
 {
-    if (get_rotation() == Rotation::portrait) {
+    if (r == Rotation::portrait) {
         return 0x48;
-    } else if (get_rotation() == Rotation::landscape) {
+    } else if (r == Rotation::landscape) {
         return 0xe8;
-    } else if (get_rotation() == Rotation::portrait2) {
+    } else if (r == Rotation::portrait2) {
         return 0x88;
     } else {
-        assert(get_rotation() == Rotation::landscape2);
+        assert(r == Rotation::landscape2);
         return 0x28;
     }
 }
@@ -0,0 +1,149 @@
+#include "numeric_field.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+#include "pixel_image.h"
+
+
+NumericField::NumericField(Framebuffer &fb, int hor, int ver,
+                           const Glyphs &glyphs, int chars,
+                           Framebuffer::HAlign align, Pad pad, int decimals,
+                           const Color bg) :
+    _fb(fb),
+    _hor(hor),
+    _ver(ver),
+    _glyphs(glyphs),
+    _chars(chars),
+    _align(align),
+    _pad(pad),
+    _decimals(decimals),
+    _bg(bg),
+    _str{},
+    _x{},
+    _len(-1),
+    _left(0),
+    _right(0),
+    _cells_sent(0)
+{
+    assert(0 < _chars && _chars <= chars_max);
+    assert(0 <= _decimals && _decimals < _chars);
+}
+
+
+void NumericField::show(int32_t value)
+{
+    char str[chars_max];
+    int len = 0;
+
+    // digits, least significant first (int64_t so INT32_MIN negates)
+    char dig[12];
+    int ndig = 0;
+    int64_t v = value;
+    const bool neg = v < 0;
+    if (neg)
+        v = -v;
+    do {
+        dig[ndig++] = char('0' + (v % 10));
+        v /= 10;
+    } while (v > 0);
+    // at least one digit before the point ("0.05")
+    while (ndig <= _decimals)
+        dig[ndig++] = '0';
+
+    const int need = ndig + (neg ? 1 : 0) + (_decimals > 0 ? 1 : 0);
+    if (need > _chars) {
+        for (len = 0; len < _chars; len++)
+            str[len] = '-';
+        draw(str, len);
+        return;
+    }
+
+    const int pad = _chars - need;
+    if (_pad == Pad::Space)
+        for (int i = 0; i < pad; i++)
+            str[len++] = ' ';
+    if (neg)
+        str[len++] = '-';
+    if (_pad == Pad::Zero)
+        for (int i = 0; i < pad; i++)
+            str[len++] = '0';
+    for (int i = ndig - 1; i >= 0; i--) {
+        str[len++] = dig[i];
+        if (i == _decimals && _decimals > 0)
+            str[len++] = '.';
+    }
+    assert(len == _chars);
+
+    draw(str, len);
+}
+
+
+void NumericField::show(const char *str)
+{
+    int len = 0;
+    while (len < chars_max && str[len] != '\0')
+        len++;
+    draw(str, len);
+}
+
+
+const PixelImageHdr *NumericField::glyph(char c) const
+{
+    if (c >= '0' && c <= '9')
+        return _glyphs.digit[c - '0'];
+    else if (c == '-')
+        return _glyphs.minus;
+    else if (c == '.')
+        return _glyphs.point;
+    else if (c == ':')
+        return _glyphs.colon;
+    else
+        return _glyphs.space;
+}
+
+
+// Send the cells of 'str' that differ from what's on the screen, then erase
+// anything the previous string covered outside the new one.
+void NumericField::draw(const char *str, int len)
+{
+    assert(len <= chars_max);
+
+    int wid = 0;
+    for (int i = 0; i < len; i++)
+        wid += glyph(str[i])->wid;
+
+    int x = _hor;
+    if (_align == Framebuffer::HAlign::Center)
+        x -= wid / 2;
+    else if (_align == Framebuffer::HAlign::Right)
+        x -= wid;
+    const int left = x;
+    const int right = x + wid;
+
+    _cells_sent = 0;
+    for (int i = 0; i < len; i++) {
+        const PixelImageHdr *img = glyph(str[i]);
+        if (i >= _len || str[i] != _str[i] || x != _x[i]) {
+            _fb.write(x, _ver, img);
+            _cells_sent++;
+        }
+        _str[i] = str[i];
+        _x[i] = int16_t(x);
+        x += img->wid;
+    }
+
+    if (_len >= 0) {
+        const int hgt = height();
+        if (_left < left)
+            _fb.fill_rect(_left, _ver, left - _left, hgt, _bg);
+        if (_right > right)
+            _fb.fill_rect(right, _ver, _right - right, hgt, _bg);
+    }
+
+    _len = len;
+    _left = left;
+    _right = right;
+}
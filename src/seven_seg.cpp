@@ -0,0 +1,204 @@
+#include "seven_seg.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+
+
+SevenSeg::SevenSeg(int hgt, int thk, int slant, bool chamfer, int wid) :
+    _hgt(hgt),
+    _wid(wid),
+    _thk(thk),
+    _slant(slant),
+    _chamfer(chamfer),
+    _mid(0)
+{
+    if (_wid <= 0)
+        _wid = _hgt / 2 + _thk;
+    _mid = (_hgt - _thk) / 2;
+
+    // room for the vertical segments between the horizontal ones
+    assert(_thk > 0 && _slant >= 0);
+    assert(_hgt >= 5 * _thk && _wid >= 3 * _thk);
+}
+
+
+uint8_t SevenSeg::segments(char c)
+{
+    static const uint8_t digits[10] = {
+        0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f,
+    };
+
+    if (c >= '0' && c <= '9')
+        return digits[c - '0'];
+
+    switch (c) {
+        case '-':
+            return seg_g;
+        case 'A':
+            return 0x77;
+        case 'b':
+            return 0x7c;
+        case 'C':
+            return 0x39;
+        case 'd':
+            return 0x5e;
+        case 'E':
+            return 0x79;
+        case 'F':
+            return 0x71;
+        case 'H':
+            return 0x76;
+        case 'L':
+            return 0x38;
+        case 'o':
+            return 0x5c;
+        case 'P':
+            return 0x73;
+        case 'r':
+            return 0x50;
+        case 'U':
+            return 0x3e;
+        default:
+            return 0; // blank
+    }
+}
+
+
+void SevenSeg::draw(Framebuffer &fb, int hor, int ver, uint8_t now,
+                    uint8_t was, const Color on, const Color off) const
+{
+    const uint8_t diff = (was & seg_unknown) ? seg_all : uint8_t(now ^ was);
+
+    for (int seg = 0; seg < 7; seg++) {
+        const uint8_t bit = uint8_t(1 << seg);
+        if (diff & bit)
+            segment(&fb, hor, ver, seg, (now & bit) ? on : off);
+    }
+}
+
+
+int SevenSeg::fills(uint8_t segs) const
+{
+    int n = 0;
+    for (int seg = 0; seg < 7; seg++)
+        if (segs & (1 << seg))
+            n += segment(nullptr, 0, 0, seg, Color::none());
+    return n;
+}
+
+
+// Chamfered ends come to a point at the middle of the stroke, reaching
+// thk/2 - 1 pixels into the corner; the ends of two segments meeting at a
+// corner then just miss each other along the diagonal.
+int SevenSeg::taper(int k) const
+{
+    const int d = 2 * k - (_thk - 1); // from the middle, in half pixels
+    return (_thk - 1 - ((d < 0) ? -d : d)) / 2;
+}
+
+
+// With 'fb' nullptr, this only counts fills.
+int SevenSeg::segment(Framebuffer *fb, int hor, int ver, int seg,
+                      const Color c) const
+{
+    const int bot = _hgt - _thk; // top row of d
+    const int right = _wid - _thk; // left column of b and c
+
+    // segment a, d, g: horizontal, with top row y
+    // segment b, c, e, f: vertical, left column x, rows [y0, y1)
+    int y = 0;
+    int x = 0, y0 = 0, y1 = 0;
+    bool horiz = false;
+    switch (seg) {
+        case 0: // a
+            horiz = true;
+            y = 0;
+            break;
+        case 1: // b
+            x = right;
+            y0 = _thk;
+            y1 = _mid;
+            break;
+        case 2: // c
+            x = right;
+            y0 = _mid + _thk;
+            y1 = bot;
+            break;
+        case 3: // d
+            horiz = true;
+            y = bot;
+            break;
+        case 4: // e
+            x = 0;
+            y0 = _mid + _thk;
+            y1 = bot;
+            break;
+        case 5: // f
+            x = 0;
+            y0 = _thk;
+            y1 = _mid;
+            break;
+        case 6: // g
+            horiz = true;
+            y = _mid;
+            break;
+        default:
+            assert(false);
+            return 0;
+    }
+
+    const int len = _wid - 2 * _thk; // horizontal segment, not chamfered
+
+    if (!_chamfer) {
+        if (horiz)
+            return rect(fb, hor, ver, _thk, y, len, _thk, c);
+        else
+            return rect(fb, hor, ver, x, y0, _thk, y1 - y0, c);
+    }
+
+    int n = 0;
+    if (horiz) {
+        // one fill per row, each longer by the taper at both ends
+        for (int r = 0; r < _thk; r++) {
+            const int t = taper(r);
+            n += rect(fb, hor, ver, _thk - t, y + r, len + 2 * t, 1, c);
+        }
+    } else {
+        // the straight part, then the points one row at a time
+        n += rect(fb, hor, ver, x, y0, _thk, y1 - y0, c);
+        for (int k = 1; k <= taper((_thk - 1) / 2); k++) {
+            // columns reaching k rows past the straight part
+            int lo = 0;
+            while (taper(lo) < k)
+                lo++;
+            const int w = _thk - 2 * lo;
+            n += rect(fb, hor, ver, x + lo, y0 - k, w, 1, c);
+            n += rect(fb, hor, ver, x + lo, y1 - 1 + k, w, 1, c);
+        }
+    }
+    return n;
+}
+
+
+// Rectangle at (x, y) in the numeral, 'w' by 'h'. Slanted, each run of rows
+// with the same shift is one fill.
+int SevenSeg::rect(Framebuffer *fb, int hor, int ver, int x, int y, int w,
+                   int h, const Color c) const
+{
+    int n = 0;
+    int row = y;
+    while (row < (y + h)) {
+        const int s = shift(row);
+        int end = row + 1;
+        while (end < (y + h) && shift(end) == s)
+            end++;
+        if (fb != nullptr)
+            fb->fill_rect(hor + x + s, ver + row, w, end - row, c);
+        n++;
+        row = end;
+    }
+    return n;
+}
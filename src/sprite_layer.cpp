@@ -0,0 +1,247 @@
+#include "sprite_layer.h"
+
+#include <cassert>
+#include <cstdint>
+
+#include "color.h"
+#include "framebuffer.h"
+#include "pixel_image.h"
+#include "sprite_image.h"
+
+
+SpriteLayer::SpriteLayer(Framebuffer &fb, const Color bg) :
+    SpriteLayer(fb, nullptr, 0, 0, bg)
+{
+}
+
+
+SpriteLayer::SpriteLayer(Framebuffer &fb, const PixelImageHdr *bg_img,
+                         int bg_hor, int bg_ver, const Color bg) :
+    _fb(fb),
+    _bg_img(bg_img),
+    _bg_hor(bg_hor),
+    _bg_ver(bg_ver),
+    _bg(bg),
+    _sprites{},
+    _num_sprites(0),
+    _pixels_sent(0)
+{
+}
+
+
+int SpriteLayer::add(const PixelImageHdr *image)
+{
+    return add(image, nullptr, image->wid, image->hgt);
+}
+
+
+int SpriteLayer::add(const SpriteImageHdr *sprite)
+{
+    return add(nullptr, sprite, sprite->wid, sprite->hgt);
+}
+
+
+int SpriteLayer::add(const PixelImageHdr *image, const SpriteImageHdr *sprite,
+                     int wid, int hgt)
+{
+    if (_num_sprites >= sprites_max)
+        return -1;
+    _sprites[_num_sprites] = Sprite{image, sprite, wid, hgt, 0, 0, false};
+    return _num_sprites++;
+}
+
+
+void SpriteLayer::move(int id, int hor, int ver)
+{
+    assert(0 <= id && id < _num_sprites);
+    Sprite &s = _sprites[id];
+
+    _pixels_sent = 0;
+
+    const Rect from = s.shown ? rect(s) : Rect{0, 0, 0, 0};
+    const Rect to{hor, ver, s.wid, s.hgt};
+
+    uncover(id, to);
+
+    s.hor = hor;
+    s.ver = ver;
+    s.shown = true;
+
+    draw(id, from);
+}
+
+
+void SpriteLayer::hide(int id)
+{
+    assert(0 <= id && id < _num_sprites);
+    Sprite &s = _sprites[id];
+
+    _pixels_sent = 0;
+
+    if (!s.shown)
+        return;
+
+    const Rect from = rect(s);
+
+    uncover(id, Rect{0, 0, 0, 0});
+
+    s.shown = false;
+
+    draw(-1, from);
+}
+
+
+void SpriteLayer::redraw()
+{
+    _pixels_sent = 0;
+
+    for (int id = 0; id < _num_sprites; id++)
+        if (_sprites[id].shown)
+            draw_sprite(id);
+}
+
+
+bool SpriteLayer::overlap(const Rect &a, const Rect &b)
+{
+    return a.wid > 0 && a.hgt > 0 && b.wid > 0 && b.hgt > 0 &&
+           a.hor < (b.hor + b.wid) && b.hor < (a.hor + a.wid) &&
+           a.ver < (b.ver + b.hgt) && b.ver < (a.ver + a.hgt);
+}
+
+
+// wid or hgt <= 0 if they don't overlap
+SpriteLayer::Rect SpriteLayer::intersect(const Rect &a, const Rect &b)
+{
+    const int left = (a.hor > b.hor) ? a.hor : b.hor;
+    const int top = (a.ver > b.ver) ? a.ver : b.ver;
+    const int a_right = a.hor + a.wid;
+    const int b_right = b.hor + b.wid;
+    const int a_bottom = a.ver + a.hgt;
+    const int b_bottom = b.ver + b.hgt;
+    const int right = (a_right < b_right) ? a_right : b_right;
+    const int bottom = (a_bottom < b_bottom) ? a_bottom : b_bottom;
+    return Rect{left, top, right - left, bottom - top};
+}
+
+
+// The part of 'a' not in 'b', as up to four rectangles in 'out': full-width
+// strips above and below 'b', then the parts left and right of it. Returns
+// the number of rectangles.
+int SpriteLayer::subtract(const Rect &a, const Rect &b, Rect *out)
+{
+    if (!overlap(a, b)) {
+        if (a.wid <= 0 || a.hgt <= 0)
+            return 0;
+        out[0] = a;
+        return 1;
+    }
+
+    const Rect mid = intersect(a, b);
+    int n = 0;
+
+    if (mid.ver > a.ver)
+        out[n++] = Rect{a.hor, a.ver, a.wid, mid.ver - a.ver};
+    if ((mid.ver + mid.hgt) < (a.ver + a.hgt))
+        out[n++] = Rect{a.hor, mid.ver + mid.hgt, a.wid,
+                        (a.ver + a.hgt) - (mid.ver + mid.hgt)};
+    if (mid.hor > a.hor)
+        out[n++] = Rect{a.hor, mid.ver, mid.hor - a.hor, mid.hgt};
+    if ((mid.hor + mid.wid) < (a.hor + a.wid))
+        out[n++] = Rect{mid.hor + mid.wid, mid.ver,
+                        (a.hor + a.wid) - (mid.hor + mid.wid), mid.hgt};
+
+    return n;
+}
+
+
+// Restore the background in 'r': from the background image where it covers
+// 'r', and with the background color elsewhere.
+void SpriteLayer::restore(Rect r)
+{
+    r = intersect(r, Rect{0, 0, _fb.width(), _fb.height()});
+    if (r.wid <= 0 || r.hgt <= 0)
+        return;
+
+    _pixels_sent += r.wid * r.hgt;
+
+    if (_bg_img == nullptr) {
+        _fb.fill_rect(r.hor, r.ver, r.wid, r.hgt, _bg);
+        return;
+    }
+
+    const Rect img{_bg_hor, _bg_ver, _bg_img->wid, _bg_img->hgt};
+
+    const Rect in = intersect(r, img);
+    if (in.wid > 0 && in.hgt > 0)
+        _fb.write(in.hor, in.ver, _bg_img, in.hor - _bg_hor, in.ver - _bg_ver,
+                  in.wid, in.hgt);
+
+    Rect out[4];
+    const int n = subtract(r, img, out);
+    for (int i = 0; i < n; i++)
+        _fb.fill_rect(out[i].hor, out[i].ver, out[i].wid, out[i].hgt, _bg);
+}
+
+
+// Restore what sprite 'id' covers at its current position. An opaque
+// sprite going to 'to' doesn't need what's under 'to' restored.
+void SpriteLayer::uncover(int id, const Rect &to)
+{
+    const Sprite &s = _sprites[id];
+    if (!s.shown)
+        return;
+
+    if (s.image != nullptr) {
+        Rect parts[4];
+        const int n = subtract(rect(s), to, parts);
+        for (int i = 0; i < n; i++)
+            restore(parts[i]);
+        return;
+    }
+
+    // color-keyed: the opaque rectangles (records of x, y, wid, hgt, then
+    // the pixels)
+    typedef SpriteImage<0, 0, 0> SpriteImage0;
+    const uint16_t *data =
+        reinterpret_cast<const SpriteImage0 *>(s.sprite)->data;
+    const uint16_t *end = data + s.sprite->len;
+    while (data < end) {
+        restore(Rect{s.hor + data[0], s.ver + data[1], data[2], data[3]});
+        data += 4 + data[2] * data[3];
+    }
+}
+
+
+// Draw sprite 'id' (-1 for none), and any other shown sprite that needs it:
+// those touching 'restored', and those above one being drawn that it
+// overlaps. They're drawn bottom to top.
+void SpriteLayer::draw(int id, const Rect &restored)
+{
+    bool dirty[sprites_max] = {};
+
+    for (int j = 0; j < _num_sprites; j++) {
+        const Sprite &s = _sprites[j];
+        if (!s.shown)
+            continue;
+        dirty[j] = (j == id) || overlap(rect(s), restored);
+        for (int i = 0; i < j && !dirty[j]; i++)
+            dirty[j] = dirty[i] && overlap(rect(_sprites[i]), rect(s));
+    }
+
+    for (int j = 0; j < _num_sprites; j++)
+        if (dirty[j])
+            draw_sprite(j);
+}
+
+
+void SpriteLayer::draw_sprite(int id)
+{
+    const Sprite &s = _sprites[id];
+    if (s.image != nullptr) {
+        _fb.write(s.hor, s.ver, s.image);
+        _pixels_sent += s.wid * s.hgt;
+    } else {
+        _fb.write_sprite(s.hor, s.ver, s.sprite);
+        _pixels_sent += s.sprite->len - 4 * s.sprite->rects;
+    }
+}
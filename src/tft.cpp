@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <utility>
 // pico
 #include "hardware/dma.h"
@@ -13,7 +14,10 @@
 // framebuffer
 #include "color.h"
 #include "font.h"
+#include "font_atlas.h"
 #include "framebuffer.h"
+#include "glyph_raster.h"
+#include "indexed_image.h"
 #include "pixel_565.h"
 #include "pixel_image.h"
 //
@@ -43,10 +47,32 @@ Tft::Tft(spi_inst_t *spi, int miso_pin, int mosi_pin, int clk_pin,
     // _dma_cfg
     _dma_running(false),
     _dma_pixel(0),
+    _trace(nullptr),
+    _trace_dma(false),
+    _glyph_cache(nullptr),
+    _line_glyph(nullptr),
+    _line_glyph_max(0),
+    _line_cov(nullptr),
+    _line_wid_max(0),
+    // _blend
+    _blend_fg(0),
+    _blend_bg(0),
+    _blend_valid(false),
+    _madctl(0),
     _pix_buf((Pixel565 *)work),
     _pix_buf_len(work_bytes / sizeof(Pixel565)),
+    _stream_half(0),
     // _ops[]
     _ops_stall_cnt(0),
+    _op_seq(0),
+    _op_done(0),
+    _op_active(false),
+    _op_rows(0),
+    _op_src(nullptr),
+    _op_stride(0),
+    _op_wid(0),
+    _op_tile_end(nullptr),
+    _op_tile_len(0),
     _op_next(0),
     _op_free(0)
 {
@@ -156,16 +182,19 @@ void Tft::set_rotation(Rotation r)
 
     wait_idle(); // wait for any queued dmas to finish
 
-    spi_set_format(_spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
-    spi_write_command(MADCTL);
-    spi_write_data(madctl());
+    madctl_set(madctl(get_rotation()));
 }
 
 
-void Tft::set_window(uint16_t hor, uint16_t ver, uint16_t wid, uint16_t hgt)
+void Tft::set_window(uint16_t hor, uint16_t ver, uint16_t wid, uint16_t hgt,
+                     uint8_t madctl)
 {
     //DbgGpio d(28);
 
+    trace_begin(Trace::Event::Window);
+
+    madctl_set(madctl);
+
     spi_set_format(_spi, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
 
     spi_write_command(CASET);
@@ -179,6 +208,8 @@ void Tft::set_window(uint16_t hor, uint16_t ver, uint16_t wid, uint16_t hgt)
     const uint v2 = ver + hgt - 1;
     spi_write_data(uint8_t(ver >> 8), uint8_t(ver), uint8_t(v2 >> 8),
                    uint8_t(v2));
+
+    trace_end(Trace::Event::Window);
 }
 
 
@@ -186,7 +217,7 @@ void Tft::pixel(int hor, int ver, const Color c)
 {
     wait_idle();
 
-    set_window(hor, ver, 1, 1); // sets to 8-bit spi
+    set_window(hor, ver, 1, 1, madctl(get_rotation())); // sets to 8-bit spi
     spi_write_command(RAMWR);
     const Pixel565 p = c; // Pixel565::operator= converts from Color
     spi_write_data(p.value());
@@ -237,8 +268,36 @@ void Tft::draw_rect(int hor, int ver, int wid, int hgt, const Color c)
 
 void Tft::dma_handler()
 {
+    if (_trace_dma) {
+        // we're here because the previous transfer finished
+        trace_end(Trace::Event::Dma);
+        _trace_dma = false;
+    }
+
+    if (_op_rows > 0) {
+        // Next row of a strided Copy op or a Pattern op. The window and the
+        // channel's control (read increment, ring) are still set. The spi
+        // is still sending the last row's pixels; no need to wait, since the
+        // dma is paced by the spi's dreq and this is the same pixel stream.
+        _op_rows--;
+        _op_src += _op_stride;
+        if (_op_tile_end != nullptr && _op_src >= _op_tile_end)
+            _op_src -= _op_tile_len;
+        trace_dma_begin(_op_wid);
+        dma_channel_set_read_addr(_dma_ch, _op_src, false);
+        dma_channel_set_trans_count(_dma_ch, _op_wid, true); // go!
+        return;
+    }
+
+    // set_window changes DC, so the last pixels must be out first
     spi_wait();
 
+    if (_op_active) {
+        // the previous op's transfer finished
+        _op_done = _op_done + 1;
+        _op_active = false;
+    }
+
     // anything new to do?
     if (ops_empty()) {
         busy(false);
@@ -250,11 +309,13 @@ void Tft::dma_handler()
             const int hgt = _ops[_op_next].hgt;
             _dma_pixel = _ops[_op_next].pixel;
             __dmb(); // _dma_pixel must be in memory before starting dma
-            set_window(hor, ver, wid, hgt); // sets to 8-bit spi
+            const uint8_t mad = _ops[_op_next].madctl;
+            set_window(hor, ver, wid, hgt, mad); // sets to 8-bit spi
             spi_write_command(RAMWR);
             data();
             spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
             channel_config_set_read_increment(&_dma_cfg, false);
+            trace_dma_begin(wid * hgt);
             dma_channel_configure(_dma_ch, &_dma_cfg, &spi_get_hw(_spi)->dr,
                                   &_dma_pixel, wid * hgt, true); // go!
         } else if (_ops[_op_next].op == AsyncOp::Copy) {
@@ -262,17 +323,68 @@ void Tft::dma_handler()
             const int ver = _ops[_op_next].ver;
             const int wid = _ops[_op_next].wid;
             const int hgt = _ops[_op_next].hgt;
+            const int stride = _ops[_op_next].stride;
             const void *pixels = _ops[_op_next].pixels;
-            set_window(hor, ver, wid, hgt); // sets to 8-bit spi
+            const uint8_t mad = _ops[_op_next].madctl;
+            set_window(hor, ver, wid, hgt, mad); // sets to 8-bit spi
             spi_write_command(RAMWR);
             data();
             spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
             channel_config_set_read_increment(&_dma_cfg, true);
+            int len = wid * hgt;
+            if (stride != wid && hgt > 1) {
+                // first row now, the rest as each one finishes
+                len = wid;
+                _op_rows = hgt - 1;
+                _op_src = (const uint16_t *)pixels;
+                _op_stride = stride;
+                _op_wid = wid;
+                _op_tile_end = nullptr;
+            }
+            trace_dma_begin(len);
             dma_channel_configure(_dma_ch, &_dma_cfg, &spi_get_hw(_spi)->dr,
-                                  pixels, wid * hgt, true); // go!
+                                  pixels, len, true); // go!
+        } else if (_ops[_op_next].op == AsyncOp::Pattern) {
+            const int hor = _ops[_op_next].hor;
+            const int ver = _ops[_op_next].ver;
+            const int wid = _ops[_op_next].wid;
+            const int hgt = _ops[_op_next].hgt;
+            const int tile_wid = _ops[_op_next].stride;
+            const int tile_hgt = _ops[_op_next].tile_hgt;
+            const uint16_t *tile = (const uint16_t *)_ops[_op_next].pixels;
+            const uint8_t mad = _ops[_op_next].madctl;
+            set_window(hor, ver, wid, hgt, mad); // sets to 8-bit spi
+            spi_write_command(RAMWR);
+            data();
+            spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+            // Reads wrap within the tile row, which is aligned to its size
+            // (a power of two), so a transfer repeats the row as long as it
+            // runs. The tile is anchored to the screen.
+            dma_channel_config cfg = _dma_cfg;
+            channel_config_set_read_increment(&cfg, true);
+            channel_config_set_ring(&cfg, false, // read
+                                    __builtin_ctz(tile_wid * sizeof(uint16_t)));
+            const uint16_t *src =
+                tile + (ver % tile_hgt) * tile_wid + (hor % tile_wid);
+            int len = wid * hgt;
+            if ((tile_hgt > 1 || (wid % tile_wid) != 0) && hgt > 1) {
+                // each row starts back at the tile's column: first row
+                // now, the rest as each one finishes
+                len = wid;
+                _op_rows = hgt - 1;
+                _op_src = src;
+                _op_stride = tile_wid;
+                _op_wid = wid;
+                _op_tile_end = tile + tile_wid * tile_hgt;
+                _op_tile_len = tile_wid * tile_hgt;
+            }
+            trace_dma_begin(len);
+            dma_channel_configure(_dma_ch, &cfg, &spi_get_hw(_spi)->dr, src,
+                                  len, true); // go!
         } else {
-            assert(false); // only Fill and Copy
+            assert(false); // only Fill, Copy, and Pattern
         }
+        _op_active = true;
         op_next_inc();
     }
 }
@@ -306,6 +418,7 @@ void Tft::fill_rect(int hor, int ver, int wid, int hgt, const Color c)
     Pixel565 p = c; // Pixel565::operator= converts from Color
 
     _ops[_op_free].op = AsyncOp::Fill;
+    _ops[_op_free].madctl = madctl(get_rotation());
     _ops[_op_free].hor = uint16_t(hor);
     _ops[_op_free].ver = uint16_t(ver);
     _ops[_op_free].wid = uint16_t(wid);
@@ -318,6 +431,7 @@ void Tft::fill_rect(int hor, int ver, int wid, int hgt, const Color c)
     uint32_t irq_state = save_and_disable_interrupts();
 
     op_free_inc();
+    _op_seq++;
 
     // force interrupt to start if it's there's not something already running
     if (!busy()) {
@@ -327,15 +441,90 @@ void Tft::fill_rect(int hor, int ver, int wid, int hgt, const Color c)
 
     restore_interrupts(irq_state);
 
+    trace_instant(Trace::Event::Enqueue, uint32_t(AsyncOp::Fill));
+
 } // void Tft::fill_rect
 
 
+// Fill ('hor', 'ver', 'wid', 'hgt') with a 'pat_wid' x 'pat_hgt' tile (see
+// fill_pattern.h). 'pat_wid' must be a power of two, and each row of the
+// tile aligned to its size. The tile must stay put until the op has
+// finished.
+void Tft::fill_pattern(int hor, int ver, int wid, int hgt,
+                       const Pixel565 *pattern, int pat_wid, int pat_hgt)
+{
+    assert(pat_wid > 0 && pat_wid <= 256 && (pat_wid & (pat_wid - 1)) == 0);
+    assert(pat_hgt > 0);
+    assert((uintptr_t(pattern) % (pat_wid * sizeof(Pixel565))) == 0);
+
+    // crop to the screen (the tile is anchored to the screen, so this
+    // doesn't move it)
+    if (hor < 0) {
+        wid += hor;
+        hor = 0;
+    }
+    if (ver < 0) {
+        hgt += ver;
+        ver = 0;
+    }
+    if ((hor + wid) > width())
+        wid = width() - hor;
+    if ((ver + hgt) > height())
+        hgt = height() - ver;
+    if (wid <= 0 || hgt <= 0)
+        return;
+
+    if (ops_full()) {
+        // wait for space
+        _ops_stall_cnt++;
+        while (ops_full())
+            tight_loop_contents();
+    }
+
+    const void *pixels = pattern;
+
+    // if the tile is in XIP memory (flash), use non-cached access
+    if (is_xip(pixels))
+        pixels = xip_nocache(pixels);
+
+    _ops[_op_free].op = AsyncOp::Pattern;
+    _ops[_op_free].madctl = madctl(get_rotation());
+    _ops[_op_free].hor = uint16_t(hor);
+    _ops[_op_free].ver = uint16_t(ver);
+    _ops[_op_free].wid = uint16_t(wid);
+    _ops[_op_free].hgt = uint16_t(hgt);
+    _ops[_op_free].stride = uint16_t(pat_wid);
+    _ops[_op_free].tile_hgt = uint16_t(pat_hgt);
+    _ops[_op_free].pixels = pixels;
+
+    // _ops[] must be visible in memory (to isr) before updating _op_free
+    __dmb();
+
+    uint32_t irq_state = save_and_disable_interrupts();
+
+    op_free_inc();
+    _op_seq++;
+
+    // force interrupt to start if it's there's not something already running
+    if (!busy()) {
+        dma_irqn_mux_force(0, _dma_ch, true);
+        busy(true);
+    }
+
+    restore_interrupts(irq_state);
+
+    trace_instant(Trace::Event::Enqueue, uint32_t(AsyncOp::Pattern));
+
+} // Tft::fill_pattern
+
+
 // write array of pixels to screen
 // ('hor', 'ver') is the top left pixel
 // 'image' points to a PixelImage, which contains width, height, and the
 // pixel data. It cannot be reused or reallocated until the write is finished,
 // which will be some time after this function returns.
 // 'align' controls horizontal alignment: left (default), center, or right.
+// An image partly off the screen is cropped (see write(..., x, y, wid, hgt)).
 void Tft::write(int hor, int ver, const PixelImageHdr *image, HAlign align)
 {
     // adjust for alignment
@@ -344,19 +533,204 @@ void Tft::write(int hor, int ver, const PixelImageHdr *image, HAlign align)
     else if (align == HAlign::Right)
         hor -= image->wid;
 
-    // can't start off the left edge or above the top
-    if (hor < 0 || ver < 0)
+    // Not entirely on the screen? Since (hor + wid) is the first pixel after
+    // the one we're writing, (hor + wid) == width is okay.
+    if (hor < 0 || ver < 0 || (hor + image->wid) > width() ||
+        (ver + image->hgt) > height()) {
+        const PixelImageView view{image, 0, 0, image->wid, image->hgt};
+        Framebuffer::write(hor, ver, view); // crops
         return;
+    }
 
-    // Don't try to go past right edge. Since (hor + wid) is the first pixel
-    // after the one we're writing, (hor + wid) == width is okay
-    if ((hor + image->wid) > width())
+    op_copy(hor, ver, image->wid, image->hgt,
+            reinterpret_cast<const PixelImage565 *>(image)->pixels);
+
+} // Tft::write
+
+
+// Write the ('x', 'y', 'wid', 'hgt') part of an image, with its top left at
+// ('hor', 'ver'). The part must be inside the image, and on the screen, or
+// nothing is written. Like writing a whole PixelImage, this is asynchronous
+// and the image must stay put until the op has finished.
+//
+// Rows of the part are sent by chained dma transfers, one per row, started
+// from the dma interrupt as each finishes (see dma_handler); a full-width
+// part's rows are contiguous and go in one transfer.
+void Tft::write(int hor, int ver, const PixelImageHdr *image, int x, int y,
+                int wid, int hgt)
+{
+    if (x < 0 || y < 0 || wid <= 0 || hgt <= 0 ||
+        (x + wid) > image->wid || (y + hgt) > image->hgt)
         return;
 
-    // Don't try to go past bottom edge.
-    if ((ver + image->hgt) > height())
+    if (hor < 0 || ver < 0 || (hor + wid) > width() ||
+        (ver + hgt) > height())
+        return;
+
+    const Pixel565 *pixels =
+        reinterpret_cast<const PixelImage565 *>(image)->pixels;
+
+    op_copy(hor, ver, wid, hgt, pixels + y * image->wid + x, image->wid);
+
+} // Tft::write
+
+
+// Write an image rotated and/or mirrored, with its top left at ('hor', 'ver')
+// on the screen. The pixels are sent in their usual order, one async Copy op,
+// to a window set with the controller's addressing remapped so they land
+// rotated (see orient_window).
+void Tft::write(int hor, int ver, const PixelImageHdr *image, Orient orient)
+{
+    const bool turned = (int(orient) & 1) != 0; // 90 or 270
+    const int wid = turned ? image->hgt : image->wid; // on the screen
+    const int hgt = turned ? image->wid : image->hgt;
+
+    if (hor < 0 || ver < 0 || (hor + wid) > width() || (ver + hgt) > height())
         return;
 
+    const uint8_t mad = orient_window(orient, hor, ver, image->wid, image->hgt);
+
+    op_copy(hor, ver, image->wid, image->hgt,
+            reinterpret_cast<const PixelImage565 *>(image)->pixels, 0, mad);
+
+} // Tft::write
+
+
+// Where content drawn in another orientation goes, in the controller's terms.
+//
+// Rotation by 90 degrees is done with the MADCTL value for the next rotation
+// around: content drawn in rotation R + 1 appears rotated 90 degrees
+// counterclockwise in rotation R, since a point (x, y) in rotation R is at
+// (hgt - 1 - y, x) in rotation R + 1 ('hgt' being rotation R's height). So
+// content rotated 'q' quarter turns clockwise is drawn in rotation R - q,
+// the window moved to match. That uses only the subclass's madctl() values.
+//
+// Mirroring reverses the order in which the controller fills columns. With
+// rows and columns exchanged (MV), that's the row address order (MY),
+// otherwise the column address order (MX).
+uint8_t Tft::orient_window(Orient orient, int &hor, int &ver, int wid,
+                           int hgt) const
+{
+    const int q = int(orient) & 3; // quarter turns clockwise
+    const bool mirror = (int(orient) & 4) != 0;
+
+    // the content's box on the screen, inclusive
+    int x0 = hor;
+    int y0 = ver;
+    int x1 = hor + ((q & 1) ? hgt : wid) - 1;
+    int y1 = ver + ((q & 1) ? wid : hgt) - 1;
+
+    // move it to the rotation it'll be drawn in
+    int r = int(get_rotation());
+    int r_wid = width();
+    int r_hgt = height();
+    for (int k = (4 - q) % 4; k > 0; k--) {
+        const int nx0 = r_hgt - 1 - y1;
+        const int nx1 = r_hgt - 1 - y0;
+        y0 = x0;
+        y1 = x1;
+        x0 = nx0;
+        x1 = nx1;
+        std::swap(r_wid, r_hgt);
+        r = (r + 1) % 4;
+    }
+
+    uint8_t mad = madctl(Rotation(r));
+
+    if (mirror) {
+        x0 = r_wid - 1 - x1;
+        mad ^= (mad & MADCTL_MV) ? MADCTL_MY : MADCTL_MX;
+    }
+
+    hor = x0;
+    ver = y0;
+    return mad;
+}
+
+
+// Write the rectangles of an image patch (see image_patch.h) over the image
+// at ('hor', 'ver'). Each is an async Copy op from the patch's data, which is
+// normally in flash.
+void Tft::write_patch(int hor, int ver, const ImagePatchHdr *patch)
+{
+    op_copy_rects(hor, ver, reinterpret_cast<const ImagePatch0 *>(patch)->data,
+                  patch->len);
+
+} // Tft::write_patch
+
+
+// Write rectangles in ImagePatch form from 'data' (e.g. an Animation's
+// frame), offset by ('hor', 'ver'). Each is an async Copy op.
+void Tft::write_rects(int hor, int ver, const uint16_t *data, int len)
+{
+    op_copy_rects(hor, ver, data, len);
+
+} // Tft::write_rects
+
+
+// Write a color-keyed sprite (see sprite_image.h) with its top left at
+// ('hor', 'ver'), adjusted by 'align'. Only the opaque pixels are sent, each
+// rectangle of them an async Copy op from the sprite's data.
+void Tft::write_sprite(int hor, int ver, const SpriteImageHdr *sprite,
+                       HAlign align)
+{
+    if (align == HAlign::Center)
+        hor -= sprite->wid / 2;
+    else if (align == HAlign::Right)
+        hor -= sprite->wid;
+
+    op_copy_rects(hor, ver,
+                  reinterpret_cast<const SpriteImage0 *>(sprite)->data,
+                  sprite->len);
+
+} // Tft::write_sprite
+
+
+// Queue a Copy op for each rectangle in 'data', records of x, y, wid, hgt,
+// then the pixels (the form of both ImagePatch and SpriteImage), offset by
+// ('hor', 'ver'). Rectangles partly off the screen are cropped, the rows of
+// what's left sent with a stride; ones entirely off the screen are skipped.
+void Tft::op_copy_rects(int hor, int ver, const uint16_t *data, int len)
+{
+    const uint16_t *end = data + len;
+    while (data < end) {
+        int h = hor + data[0];
+        int v = ver + data[1];
+        const int stride = data[2];
+        int wid = data[2];
+        int hgt = data[3];
+        const uint16_t *pixels = data + 4;
+        data += 4 + wid * hgt;
+
+        if (h < 0) {
+            pixels -= h;
+            wid += h;
+            h = 0;
+        }
+        if (v < 0) {
+            pixels -= v * stride;
+            hgt += v;
+            v = 0;
+        }
+        if ((h + wid) > width())
+            wid = width() - h;
+        if ((v + hgt) > height())
+            hgt = height() - v;
+        if (wid <= 0 || hgt <= 0)
+            continue;
+
+        op_copy(h, v, wid, hgt, pixels, stride);
+    }
+}
+
+
+// Queue a Copy op: send 'pixels' to the ('hor', 'ver', 'wid', 'hgt') window.
+// Rows start 'stride' pixels apart (0 means 'wid'). The window is set with
+// MADCTL value 'madctl' (-1 means the rotation's). The pixels must stay put
+// until the op has finished.
+void Tft::op_copy(int hor, int ver, int wid, int hgt, const void *pixels,
+                  int stride, int madctl)
+{
     if (ops_full()) {
         // Wait for space. We want waiting here to be rare. Very rare.
         _ops_stall_cnt++;
@@ -364,17 +738,18 @@ void Tft::write(int hor, int ver, const PixelImageHdr *image, HAlign align)
             tight_loop_contents();
     }
 
-    const void *pixels = reinterpret_cast<const PixelImage565 *>(image)->pixels;
-
     // if pixels is in XIP memory (flash), use non-cached access
     if (is_xip(pixels))
         pixels = xip_nocache(pixels);
 
     _ops[_op_free].op = AsyncOp::Copy;
+    _ops[_op_free].madctl =
+        uint8_t((madctl >= 0) ? madctl : this->madctl(get_rotation()));
     _ops[_op_free].hor = uint16_t(hor);
     _ops[_op_free].ver = uint16_t(ver);
-    _ops[_op_free].wid = uint16_t(image->wid);
-    _ops[_op_free].hgt = uint16_t(image->hgt);
+    _ops[_op_free].wid = uint16_t(wid);
+    _ops[_op_free].hgt = uint16_t(hgt);
+    _ops[_op_free].stride = uint16_t((stride > 0) ? stride : wid);
     _ops[_op_free].pixels = pixels;
 
     // _ops[] must be visible in memory (to isr) before updating _op_free
@@ -383,6 +758,7 @@ void Tft::write(int hor, int ver, const PixelImageHdr *image, HAlign align)
     uint32_t irq_state = save_and_disable_interrupts();
 
     op_free_inc();
+    _op_seq++;
 
     // force interrupt to start if it's there's not something already running
     if (!busy()) {
@@ -392,9 +768,367 @@ void Tft::write(int hor, int ver, const PixelImageHdr *image, HAlign align)
 
     restore_interrupts(irq_state);
 
+    trace_instant(Trace::Event::Enqueue, uint32_t(AsyncOp::Copy));
+
+} // Tft::op_copy
+
+
+// Start streaming pixels to the ('hor', 'ver', 'wid', 'hgt') window, set with
+// MADCTL value 'madctl' (-1 means the rotation's).
+void Tft::stream_start(int hor, int ver, int wid, int hgt, int madctl)
+{
+    assert(stream_buf_len() > 0);
+
+    // Wait for any queued dmas to finish.
+    wait_idle();
+
+    if (madctl < 0)
+        madctl = this->madctl(get_rotation());
+
+    set_window(hor, ver, wid, hgt, uint8_t(madctl)); // sets to 8-bit spi
+    spi_write_command(RAMWR);
+    data();
+    spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+
+    _stream_half = 0;
+}
+
+
+// Send 'len' pixels from stream_buf(), then switch to the other half.
+//
+// The previous send must finish before this one starts, which also means
+// the half we're switching to is free to be filled.
+void Tft::stream_send(int len)
+{
+    assert(0 < len && len <= stream_buf_len());
+
+    const Pixel565 *buf = stream_buf();
+
+    while (busy())
+        tight_loop_contents();
+
+    busy(true);
+    trace_dma_begin(len);
+    channel_config_set_read_increment(&_dma_cfg, true);
+    dma_channel_configure(_dma_ch, &_dma_cfg, &spi_get_hw(_spi)->dr, buf, len,
+                          true); // go!
+
+    _stream_half ^= 1;
+}
+
+
+// Send the last 'len' pixels sent again (the end of the half stream_send
+// last sent), without switching halves.
+//
+// The half being filled is left alone, so the next one can be filled while
+// the repeats go.
+void Tft::stream_resend(int len)
+{
+    assert(0 < len && len <= stream_buf_len());
+
+    const Pixel565 *buf = _pix_buf + (_stream_half ^ 1) * stream_buf_len();
+
+    while (busy())
+        tight_loop_contents();
+
+    busy(true);
+    trace_dma_begin(len);
+    channel_config_set_read_increment(&_dma_cfg, true);
+    dma_channel_configure(_dma_ch, &_dma_cfg, &spi_get_hw(_spi)->dr, buf, len,
+                          true); // go!
+}
+
+
+// Write a run-length compressed image (see rle_image.h).
+//
+// Unlike writing a PixelImage, this is not asynchronous: the image is
+// decoded into _pix_buf a chunk at a time while dma sends the previous
+// chunk, and it returns once the last chunk has been sent. A bigger _pix_buf
+// means fewer chunks, and throughput closer to that of a PixelImage.
+//
+// 'align' and edge handling are the same as for writing a PixelImage.
+void Tft::write(int hor, int ver, const RleImageHdr *image, HAlign align)
+{
+    if (align == HAlign::Center)
+        hor -= image->wid / 2;
+    else if (align == HAlign::Right)
+        hor -= image->wid;
+
+    if (hor < 0 || ver < 0)
+        return;
+
+    if ((hor + image->wid) > width())
+        return;
+
+    if ((ver + image->hgt) > height())
+        return;
+
+    const uint16_t *src = reinterpret_cast<const RleImage0 *>(image)->data;
+
+    stream_start(hor, ver, image->wid, image->hgt);
+
+    const int buf_len = stream_buf_len();
+    uint16_t *buf = reinterpret_cast<uint16_t *>(stream_buf());
+    int n = 0; // pixels in buf
+
+    int cnt = 0;      // pixels left in current run or literal
+    bool lit = false; // current is literal (else run)
+    uint16_t val = 0; // run value
+
+    int remaining = image->wid * image->hgt;
+    while (remaining > 0) {
+        if (cnt == 0) {
+            const uint16_t token = *src++;
+            cnt = token & rle_count_max;
+            lit = (token & rle_run_flag) == 0;
+            if (!lit)
+                val = *src++;
+            assert(cnt > 0);
+        }
+        int k = cnt;
+        if (k > (buf_len - n))
+            k = buf_len - n;
+        if (lit) {
+            for (int i = 0; i < k; i++)
+                buf[n + i] = *src++;
+        } else {
+            for (int i = 0; i < k; i++)
+                buf[n + i] = val;
+        }
+        cnt -= k;
+        n += k;
+        remaining -= k;
+        if (n == buf_len) {
+            stream_send(n);
+            buf = reinterpret_cast<uint16_t *>(stream_buf());
+            n = 0;
+        }
+    }
+
+    if (n > 0)
+        stream_send(n);
+
+    stream_finish();
+
+} // Tft::write
+
+
+// Write a palette-indexed image (see indexed_image.h).
+//
+// Like writing a run-length compressed image, this is not asynchronous.
+// Each pixel's index is looked up in 'palette' as it goes into _pix_buf,
+// and dma sends one chunk while the next is being expanded.
+//
+// 'align' and edge handling are the same as for writing a PixelImage.
+void Tft::write(int hor, int ver, const IndexedImageHdr *image,
+                const Pixel565 *palette, HAlign align)
+{
+    if (align == HAlign::Center)
+        hor -= image->wid / 2;
+    else if (align == HAlign::Right)
+        hor -= image->wid;
+
+    if (hor < 0 || ver < 0)
+        return;
+
+    if ((hor + image->wid) > width())
+        return;
+
+    if ((ver + image->hgt) > height())
+        return;
+
+    const int wid = image->wid;
+    const int hgt = image->hgt;
+    const int bpp = image->bpp;
+    assert(bpp == 1 || bpp == 2 || bpp == 4 || bpp == 8);
+    const int row_bytes = indexed_row_bytes(wid, bpp);
+    const int idx_mask = (1 << bpp) - 1;
+    const int pix_per_byte = 8 / bpp;
+
+    // palette may be in flash; pull it into ram once
+    uint16_t pal[256];
+    for (int i = 0; i <= idx_mask; i++)
+        pal[i] = palette[i].value();
+
+    const uint8_t *data = reinterpret_cast<const IndexedImage0 *>(image)->data;
+
+    stream_start(hor, ver, wid, hgt);
+
+    const int buf_len = stream_buf_len();
+    uint16_t *buf = reinterpret_cast<uint16_t *>(stream_buf());
+    int n = 0; // pixels in buf
+
+    for (int row = 0; row < hgt; row++) {
+        const uint8_t *src = data + row * row_bytes;
+        int col = 0;
+        while (col < wid) {
+            // unpack one byte
+            uint8_t b = *src++;
+            int k = pix_per_byte;
+            if (k > (wid - col))
+                k = wid - col;
+            for (int i = 0; i < k; i++) {
+                b = uint8_t((b << bpp) | (b >> (8 - bpp))); // rotate left
+                buf[n++] = pal[b & idx_mask];
+                if (n == buf_len) {
+                    stream_send(n);
+                    buf = reinterpret_cast<uint16_t *>(stream_buf());
+                    n = 0;
+                }
+            }
+            col += k;
+        }
+    }
+
+    if (n > 0)
+        stream_send(n);
+
+    stream_finish();
+
 } // Tft::write
 
 
+// write alpha-mask image to screen
+//
+// Coverage goes through the same blend table as text (blend_lut), so
+// writing several masks in the same colors, or masks and text, builds it
+// once. Each row is blended into the working buffer and sent as for an
+// indexed image.
+//
+// 'align' and edge handling are the same as for an indexed image.
+void Tft::write_mask(int hor, int ver, const MaskImageHdr *mask,
+                     const Color fg, const Color bg, HAlign align)
+{
+    if (align == HAlign::Center)
+        hor -= mask->wid / 2;
+    else if (align == HAlign::Right)
+        hor -= mask->wid;
+
+    if (hor < 0 || ver < 0)
+        return;
+
+    if ((hor + mask->wid) > width())
+        return;
+
+    if ((ver + mask->hgt) > height())
+        return;
+
+    const int wid = mask->wid;
+    const int hgt = mask->hgt;
+    const int bpp = mask->bpp;
+    assert(bpp == 4 || bpp == 8);
+    const int row_bytes = indexed_row_bytes(wid, bpp);
+
+    const uint16_t *lut =
+        reinterpret_cast<const uint16_t *>(blend_lut(fg, bg).table());
+
+    const uint8_t *data = reinterpret_cast<const MaskImage0 *>(mask)->data;
+
+    stream_start(hor, ver, wid, hgt);
+
+    const int buf_len = stream_buf_len();
+    uint16_t *buf = reinterpret_cast<uint16_t *>(stream_buf());
+    int n = 0; // pixels in buf
+
+    for (int row = 0; row < hgt; row++) {
+        const uint8_t *src = data + row * row_bytes;
+        for (int col = 0; col < wid; col++) {
+            uint8_t cov;
+            if (bpp == 8)
+                cov = src[col];
+            else if ((col & 1) == 0)
+                cov = uint8_t((src[col / 2] >> 4) * 17);
+            else
+                cov = uint8_t((src[col / 2] & 0x0f) * 17);
+            buf[n++] = lut[cov];
+            if (n == buf_len) {
+                stream_send(n);
+                buf = reinterpret_cast<uint16_t *>(stream_buf());
+                n = 0;
+            }
+        }
+    }
+
+    if (n > 0)
+        stream_send(n);
+
+    stream_finish();
+
+} // Tft::write_mask
+
+
+// Write an image scaled up 'sx' x 'sy' (nearest neighbor), with its top left
+// at ('hor', 'ver'). Nothing is written unless the scaled image is entirely
+// on the screen.
+//
+// The image stays at its own size in flash. Each source row is expanded
+// across into the working buffer, then sent 'sy' times, so the cpu does one
+// expansion per source row and dma does the rest; the next row is expanded
+// while the last copy of this one goes. A scaled row too long for half the
+// working buffer is expanded in pieces for each copy instead.
+//
+// Like writing an indexed image, this is not asynchronous; it returns when
+// the last row has been sent.
+void Tft::write_scaled(int hor, int ver, const PixelImageHdr *image, int sx,
+                       int sy)
+{
+    if (sx < 1 || sy < 1)
+        return;
+
+    const int wid = image->wid;
+    const int hgt = image->hgt;
+    const int s_wid = wid * sx; // on the screen
+    const int s_hgt = hgt * sy;
+
+    if (hor < 0 || ver < 0 || (hor + s_wid) > width() ||
+        (ver + s_hgt) > height())
+        return;
+
+    const Pixel565 *pixels =
+        reinterpret_cast<const PixelImage565 *>(image)->pixels;
+
+    stream_start(hor, ver, s_wid, s_hgt);
+
+    const int buf_len = stream_buf_len();
+
+    if (s_wid <= buf_len) {
+        for (int row = 0; row < hgt; row++) {
+            const Pixel565 *src = pixels + row * wid;
+            Pixel565 *buf = stream_buf();
+            for (int col = 0; col < wid; col++)
+                for (int i = 0; i < sx; i++)
+                    *buf++ = src[col];
+            stream_send(s_wid);
+            for (int rep = 1; rep < sy; rep++)
+                stream_resend(s_wid);
+        }
+    } else {
+        Pixel565 *buf = stream_buf();
+        int n = 0; // pixels in buf
+        for (int row = 0; row < hgt; row++) {
+            const Pixel565 *src = pixels + row * wid;
+            for (int rep = 0; rep < sy; rep++) {
+                for (int col = 0; col < wid; col++) {
+                    for (int i = 0; i < sx; i++) {
+                        buf[n++] = src[col];
+                        if (n == buf_len) {
+                            stream_send(n);
+                            buf = stream_buf();
+                            n = 0;
+                        }
+                    }
+                }
+            }
+        }
+        if (n > 0)
+            stream_send(n);
+    }
+
+    stream_finish();
+
+} // Tft::write_scaled
+
+
 // Write a number to the screen as a series of digit images.
 //
 // The digit images are pre-created, normally at compile time and stored in
@@ -454,15 +1188,17 @@ void Tft::write(int hor, int ver, int num, const PixelImageHdr *dig[10],
 }
 
 
-// Print one character to screen
+// Print one glyph to screen
 //
 // 'hor', 'ver' top left pixel of the character cell
-// 'c'          character to print
-// 'font'       font to use
+// 'g'          glyph to print (from any font type's glyph() method)
+// 'y_adv'      font height
 // 'fg', 'bg'   the foreground (glyph) and background (margin) colors
-// 'align'      left (default), center, or right
+// 'scale'      size multiplier
 //
-// The combination of 'c' and 'font' determine how big the character cell is.
+// The glyph's x_adv and the font's y_adv, times 'scale', determine how big
+// the character cell is. Alignment has already been handled
+// (Framebuffer::print).
 //
 // If the character would extend off the screen, nothing is printed.
 //
@@ -470,45 +1206,47 @@ void Tft::write(int hor, int ver, int num, const PixelImageHdr *dig[10],
 // rendering of the glyph into _pix_buf. Even if _pix_buf were big enough to
 // hold the entire character, we'd have to wait for the dma to finish before
 // reusing _pix_buf for the next character.
-void Tft::print(int hor, int ver, char c, const Font &font, //
-                    const Color fg, const Color bg, HAlign align)
+void Tft::print_glyph(int hor, int ver, const Glyph &g, int y_adv, //
+                      const Color fg, const Color bg, int scale)
 {
-    if (!font.printable(c))
+    // Can't start off the left edge or above the top.
+    if (hor < 0 || ver < 0 || scale < 1)
         return;
 
-    int ci = int(c);
+    const int8_t x_adv = g.x_adv;
+    const int wid = x_adv * scale; // window size
+    const int hgt = y_adv * scale;
 
-    // handle alignment
-    if (align != HAlign::Left) {
-        // Right-aligned or centered, back up horizontal location.
-        int adjust = font.info[ci].x_adv; // char width in pixels
-        if (align == HAlign::Center)
-            adjust = adjust / 2; // centered
-        hor -= adjust;
-    }
+    // Don't try to go past right edge. Since (hor + wid) is the first pixel
+    // after the one we're printing, (hor + wid) == width is okay.
+    if ((hor + wid) > width())
+        return;
 
-    // Can't start off the left edge or above the top.
-    if (hor < 0 || ver < 0)
+    // Don't try to go past bottom edge.
+    if ((ver + hgt) > height())
         return;
 
-    // Start of glyph data - each byte is a grayscale.
-    const uint8_t *gs = font.data + font.info[ci].off;
+    // Cells are found by the glyph's address, so only glyphs in flash are
+    // cached (not, say, a kerned overlap made on the stack; see glyph_boxes).
+    if (_glyph_cache != nullptr && scale == 1 && is_xip(g.data) &&
+        print_glyph_cached(hor, ver, g, y_adv, fg, bg))
+        return;
 
-    // These are used to "raster through" the glyph data.
-    const int8_t x_off = font.info[ci].x_off;
-    const int8_t y_off = font.info[ci].y_off;
-    const int8_t wid = font.info[ci].w;
-    const int8_t hgt = font.info[ci].h;
-    const int8_t x_adv = font.info[ci].x_adv;
+    print_glyph_window(hor, ver, g, y_adv, fg, bg, scale,
+                       madctl(get_rotation()));
+}
 
-    // Don't try to go past right edge. Since (hor + x_adv) is the first pixel
-    // after the one we're printing, (hor + x_adv) == width is okay.
-    if ((hor + x_adv) > width())
-        return;
 
-    // Don't try to go past bottom edge.
-    if ((ver + font.y_adv) > height())
-        return;
+// Render a character cell into a window at ('hor', 'ver') set with MADCTL
+// value 'mad' (see print_glyph). The window is in the controller's terms
+// for that value, and must be on the screen.
+void Tft::print_glyph_window(int hor, int ver, const Glyph &g, int y_adv,
+                             const Color fg, const Color bg, int scale,
+                             uint8_t mad)
+{
+    const int8_t x_adv = g.x_adv;
+    const int wid = x_adv * scale; // window size
+    const int hgt = y_adv * scale;
 
     // The character's 'box' is [hor...hor+x_adv) horizontally, and
     // [ver...ver+y_adv) vertically; the pixel at (hor, ver) will be filled,
@@ -517,64 +1255,447 @@ void Tft::print(int hor, int ver, char c, const Font &font, //
     // But the glyph does not necessarly fit completely in the box (and often
     // doesn't); any of these can be true, and we just crop any part of the
     // glyph outside the character's box:
-    //   x_off can be negative - glyph extends left of 'hor'
-    //   y_off can be negative - glyph extends above 'ver'
-    //   x_off + wid can extend past x_adv
-    //   y_off + hgt can extend below y_adv
+    //   g.x_off can be negative - glyph extends left of 'hor'
+    //   g.y_off can be negative - glyph extends above 'ver'
+    //   g.x_off + g.w can extend past x_adv
+    //   g.y_off + g.h can extend below y_adv
     //
     // Fonts that make a habit of extending outside the character box don't
     // render nicely. Many do it occasionally and you don't notice.
 
+    trace_begin(Trace::Event::Glyph, uint32_t(wid * hgt));
+
     // Wait for any queued dmas to finish.
     wait_idle();
 
     // Set spi transfer window - all pixels in this window will be filled.
-    set_window(hor, ver, font.info[ci].x_adv, font.y_adv); // sets to 8-bit spi
+    set_window(hor, ver, wid, hgt, mad); // 8-bit spi
 
     const uint8_t cmd = RAMWR;
     command();
     spi_write_blocking(_spi, &cmd, 1);
     data();
 
-    // Iterate through entire character box. Margins around the glyph are
-    // background. Pixels in the glyph are interpolated from the glyph data.
-    // As we iterate through the character box, we gradually fill up the
-    // working buffer _pix_buf, which might be smaller than the character box.
-    // When _pix_buf fills up, we write it out to the display then start over.
+    spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
 
-    // Assigning to _pix_buf[] from Color uses Pixel565::operator=.
+    // Render the character box a row at a time (see glyph_raster.h),
+    // collecting rows in the working buffer _pix_buf. When the next row
+    // won't fit, send what's there and start over. If _pix_buf is smaller
+    // than a row, each row is rendered into row_buf, and (when scaled)
+    // expanded into _pix_buf a buffer-full at a time for each repeat.
+    //
+    // When scaled, each row is rendered once, 'scale' times as wide, and
+    // then copied for the repeats, so the glyph is only read once.
 
-    spi_set_format(_spi, 16, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    GlyphRaster<Pixel565> raster(g, blend_lut(fg, bg));
 
-    Pixel565 bg_pix = bg; // convert once
+    Pixel565 row_buf[128]; // x_adv is int8_t
+    const bool rows_fit = wid <= _pix_buf_len;
 
     int p = 0; // indexes through _pix_buf
-    // row, col covers character box
-    for (int row = 0; row < font.y_adv; row++) {
-        for (int col = 0; col < x_adv; col++) {
-            // See if the glyph covers this pixel.
-            if (row >= y_off && row < (y_off + hgt) && //
-                col >= x_off && col < (x_off + wid)) {
-                // Yes.
-                int g_row = row - y_off;
-                assert(g_row >= 0 && g_row < hgt);
-                int g_col = col - x_off;
-                assert(g_col >= 0 && g_col < wid);
-                uint8_t gray = gs[g_row * wid + g_col];
-                _pix_buf[p++] = Color::interpolate(gray, bg, fg);
-            } else {
-                // No, outside glyph's margins.
-                _pix_buf[p++] = bg_pix;
+    for (int row = 0; row < y_adv; row++) {
+        if (!rows_fit) {
+            raster.row(row_buf);
+            if (scale == 1) {
+                spi_write16_blocking(_spi, (const uint16_t *)(row_buf), x_adv);
+                continue;
             }
-            if (p >= _pix_buf_len) {
-                // Send buffer and restart it.
-                spi_write16_blocking(_spi, (const uint16_t *)(_pix_buf),
-                                     _pix_buf_len);
-                p = 0;
+            for (int rep = 0; rep < scale; rep++) {
+                int n = 0; // pixels in _pix_buf
+                for (int col = 0; col < x_adv; col++) {
+                    for (int i = 0; i < scale; i++) {
+                        _pix_buf[n++] = row_buf[col];
+                        if (n == _pix_buf_len) {
+                            spi_write16_blocking(
+                                _spi, (const uint16_t *)(_pix_buf), n);
+                            n = 0;
+                        }
+                    }
+                }
+                if (n > 0)
+                    spi_write16_blocking(_spi, (const uint16_t *)(_pix_buf),
+                                         n);
             }
+            continue;
+        }
+        if ((p + wid) > _pix_buf_len) {
+            // Send buffer and restart it.
+            spi_write16_blocking(_spi, (const uint16_t *)(_pix_buf), p);
+            p = 0;
+        }
+        Pixel565 *line = _pix_buf + p;
+        raster.row(line, scale);
+        p += wid;
+        for (int rep = 1; rep < scale; rep++) {
+            if ((p + wid) > _pix_buf_len) {
+                // Send buffer, and restart it with the row being repeated
+                // (which has just been sent too, so this is a repeat).
+                spi_write16_blocking(_spi, (const uint16_t *)(_pix_buf), p);
+                memmove(_pix_buf, line, wid * sizeof(Pixel565));
+                line = _pix_buf;
+                p = wid;
+                continue;
+            }
+            memcpy(_pix_buf + p, line, wid * sizeof(Pixel565));
+            p += wid;
         }
     }
     // Send final (partial) buffer if necessary.
     if (p > 0)
         spi_write16_blocking(_spi, (const uint16_t *)(_pix_buf), p);
+
+    trace_end(Trace::Event::Glyph, uint32_t(wid * hgt));
+}
+
+
+
+// Attach a line buffer for whole-string printing (see tft.h). The coverage
+// row is first, as long as the longer side of the screen (_phys_wid), which
+// is the longest unscaled string that can be entirely on it in any
+// orientation; the rest is LineGlyph slots. An arena too small for one slot
+// is the same as none.
+void Tft::line_buffer(void *arena, int arena_bytes)
+{
+    const int cov_bytes = (_phys_wid + 3) & ~3; // keep the slots aligned
+
+    if (arena == nullptr || arena_bytes < line_buffer_bytes(1)) {
+        _line_glyph = nullptr;
+        _line_glyph_max = 0;
+        _line_cov = nullptr;
+        _line_wid_max = 0;
+        return;
+    }
+
+    assert((uintptr_t(arena) & 3) == 0);
+
+    _line_cov = static_cast<uint8_t *>(arena);
+    _line_wid_max = _phys_wid;
+    _line_glyph = reinterpret_cast<LineGlyph *>(_line_cov + cov_bytes);
+    _line_glyph_max = (arena_bytes - cov_bytes) / int(sizeof(LineGlyph));
+}
+
+
+int Tft::line_buffer_bytes(int chars) const
+{
+    return ((_phys_wid + 3) & ~3) + chars * int(sizeof(LineGlyph));
+}
+
+
+// Print a string into a single window (see tft.h)
+//
+// The glyphs are laid out as Framebuffer::print would (alignment, kerning),
+// then each row of the window is built as a row of coverage: each glyph with
+// that row adds its coverage, keeping the larger where glyphs overlap. The
+// coverage is blended into the stream buffer, which dma sends while the next
+// part is being blended. Scaled, each coverage value is blended once and
+// sent 'scale' times, and each row of coverage is sent 'scale' times.
+template <typename FONT>
+bool Tft::print_line(int hor, int ver, const char *str, const FONT &font,
+                     const Color fg, const Color bg, HAlign align, int scale,
+                     Orient orient)
+{
+    // (the glyph cache only has unrotated characters)
+    if ((_glyph_cache != nullptr && orient == Orient::None) ||
+        _line_glyph == nullptr || stream_buf_len() == 0 || scale < 1)
+        return false;
+
+    const int wid = font.width(str); // unscaled
+    const int hgt = font.height();
+
+    if (align != HAlign::Left) {
+        // right-aligned or centered, back up horizontal position
+        int adjust = wid * scale;
+        if (align == HAlign::Center)
+            adjust = adjust / 2;
+        hor -= adjust;
+    }
+
+    if (wid <= 0)
+        return true; // nothing to print
+
+    // The whole string must be on the screen and fit in the line buffers.
+    // Rotated by 90 or 270 degrees, its box on the screen is hgt x wid.
+    const bool turned = (int(orient) & 1) != 0;
+    const int box_wid = (turned ? hgt : wid) * scale;
+    const int box_hgt = (turned ? wid : hgt) * scale;
+    if (hor < 0 || ver < 0 || (hor + box_wid) > width() ||
+        (ver + box_hgt) > height() || wid > _line_wid_max)
+        return false;
+
+    // Lay out the glyphs.
+    int n = 0;
+    int x = 0;
+    uint32_t prev = 0;
+    for (const char *s = str; *s != '\0';) {
+        const uint32_t c = utf8_next(s);
+        x += font.kerning(prev, c);
+        prev = c;
+        if (!font.printable(c))
+            continue;
+        if (n >= _line_glyph_max)
+            return false;
+        const Glyph g = font.glyph(c);
+        LineGlyph &lg = _line_glyph[n++];
+        lg.gs = g.reader();
+        lg.x = int16_t(x + g.x_off);
+        lg.y_off = g.y_off;
+        lg.w = g.w;
+        lg.h = g.h;
+        // glyph rows above the window are cropped
+        if (g.y_off < 0)
+            lg.gs.skip(-g.y_off * g.w);
+        x += g.x_adv;
+    }
+
+    trace_begin(Trace::Event::Glyph, uint32_t(wid * hgt * scale * scale));
+
+    const Pixel565 *lut = blend_lut(fg, bg).table();
+
+    int mad = -1;
+    if (orient != Orient::None)
+        mad = orient_window(orient, hor, ver, wid * scale, hgt * scale);
+
+    stream_start(hor, ver, wid * scale, hgt * scale, mad);
+
+    const int buf_len = stream_buf_len();
+    Pixel565 *buf = stream_buf();
+    int p = 0; // indexes through buf
+
+    for (int row = 0; row < hgt; row++) {
+        memset(_line_cov, 0, wid);
+        for (int i = 0; i < n; i++) {
+            LineGlyph &lg = _line_glyph[i];
+            if (row < lg.y_off || row >= (lg.y_off + lg.h))
+                continue;
+            uint8_t cov[128]; // int8_t w
+            lg.gs.read(cov, lg.w);
+            // columns outside the window are cropped
+            const int col_beg = (lg.x < 0) ? -lg.x : 0;
+            const int col_end = ((lg.x + lg.w) > wid) ? (wid - lg.x) : lg.w;
+            for (int col = col_beg; col < col_end; col++)
+                if (cov[col] > _line_cov[lg.x + col])
+                    _line_cov[lg.x + col] = cov[col];
+        }
+        for (int rep = 0; rep < scale; rep++) {
+            for (int col = 0; col < wid; col++) {
+                const Pixel565 pix = lut[_line_cov[col]];
+                for (int i = 0; i < scale; i++) {
+                    buf[p++] = pix;
+                    if (p == buf_len) {
+                        stream_send(p);
+                        buf = stream_buf();
+                        p = 0;
+                    }
+                }
+            }
+        }
+    }
+    if (p > 0)
+        stream_send(p);
+
+    stream_finish();
+
+    trace_end(Trace::Event::Glyph, uint32_t(wid * hgt * scale * scale));
+
+    return true;
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const Font &font,
+                const Color fg, const Color bg, HAlign align, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, align, scale))
+        Framebuffer::print(hor, ver, str, font, fg, bg, align, scale);
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const FontRange &font,
+                const Color fg, const Color bg, HAlign align, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, align, scale))
+        Framebuffer::print(hor, ver, str, font, fg, bg, align, scale);
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const FontSparse &font,
+                const Color fg, const Color bg, HAlign align, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, align, scale))
+        Framebuffer::print(hor, ver, str, font, fg, bg, align, scale);
+}
+
+
+// Print a string rotated and/or mirrored a character at a time, for when it
+// can't go in one window (print_line): no line buffer, too many characters,
+// or not entirely on the screen. Each character box is its own window, as
+// in print_glyph, with the controller's addressing remapped for it (see
+// orient_window). Characters not entirely on the screen are skipped, as
+// Framebuffer::print does unrotated.
+//
+// Boxes are laid out along the string as Framebuffer::print would (see
+// glyph_boxes), in the string's box ('wid' x 'hgt', unrotated), then that
+// is mirrored and rotated onto the screen with its top left at ('hor',
+// 'ver').
+template <typename FONT>
+void Tft::print_oriented(int hor, int ver, const char *str, const FONT &font,
+                         const Color fg, const Color bg, Orient orient,
+                         int scale)
+{
+    if (scale < 1)
+        return;
+
+    const int q = int(orient) & 3; // quarter turns clockwise
+    const bool mirror = (int(orient) & 4) != 0;
+    const int wid = font.width(str) * scale;
+    const int hgt = font.height() * scale;
+
+    // ('x', 'y', 'g.x_adv' x 'rows') is a box in the string's box
+    glyph_boxes(str, font, [&](int x, int y, const Glyph &g, int rows) {
+        const int box_wid = g.x_adv * scale;
+        const int box_hgt = rows * scale;
+        x *= scale;
+        y *= scale;
+        // the box in the string's box, mirrored
+        const int bx = mirror ? (wid - x - box_wid) : x;
+        // and on the screen, rotated ('h', 'v', 'w' x 'l')
+        int h = hor;
+        int v = ver;
+        int w = box_wid;
+        int l = box_hgt;
+        if (q == 1) {
+            h += hgt - y - box_hgt;
+            v += bx;
+            w = box_hgt;
+            l = box_wid;
+        } else if (q == 2) {
+            h += wid - bx - box_wid;
+            v += hgt - y - box_hgt;
+        } else if (q == 3) {
+            h += y;
+            v += wid - bx - box_wid;
+            w = box_hgt;
+            l = box_wid;
+        } else {
+            h += bx;
+            v += y;
+        }
+        if (h >= 0 && v >= 0 && (h + w) <= width() && (v + l) <= height()) {
+            const uint8_t mad = orient_window(orient, h, v, box_wid, box_hgt);
+            print_glyph_window(h, v, g, rows, fg, bg, scale, mad);
+        }
+    });
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const Font &font,
+                const Color fg, const Color bg, Orient orient, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, HAlign::Left, scale, orient))
+        print_oriented(hor, ver, str, font, fg, bg, orient, scale);
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const FontRange &font,
+                const Color fg, const Color bg, Orient orient, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, HAlign::Left, scale, orient))
+        print_oriented(hor, ver, str, font, fg, bg, orient, scale);
+}
+
+
+void Tft::print(int hor, int ver, const char *str, const FontSparse &font,
+                const Color fg, const Color bg, Orient orient, int scale)
+{
+    if (!print_line(hor, ver, str, font, fg, bg, HAlign::Left, scale, orient))
+        print_oriented(hor, ver, str, font, fg, bg, orient, scale);
+}
+
+
+// Print a string from a FontAtlas (see font_atlas.h)
+//
+// Each character box is already rendered, so this only queues ops.
+void Tft::print(int hor, int ver, const char *str, const FontAtlas &atlas,
+                HAlign align)
+{
+    if (align != HAlign::Left) {
+        // right-aligned or centered, back up horizontal position
+        int adjust = atlas.width(str);
+        if (align == HAlign::Center)
+            adjust = adjust / 2;
+        hor -= adjust;
+    }
+
+    const int hgt = atlas.height();
+    if (ver < 0 || (ver + hgt) > height())
+        return;
+
+    uint32_t prev = 0;
+    while (*str != '\0') {
+        const uint32_t c = utf8_next(str);
+        hor += atlas.kerning(prev, c);
+        prev = c;
+        const int wid = atlas.width(c);
+        if (wid > 0 && hor >= 0 && (hor + wid) <= width())
+            op_copy(hor, ver, wid, hgt, atlas.box(c));
+        hor += wid;
+    }
+}
+
+// Print one glyph using the glyph cache (see glyph_cache.h)
+//
+// On a miss, the character cell is rendered into a cache cell (the same way
+// print_glyph renders it into _pix_buf). Either way it is then sent with an
+// async Copy op, so this doesn't wait for earlier ops to finish, except when
+// the cell being reused is still queued to be sent from its previous use.
+//
+// Returns false (having done nothing) if the character box doesn't fit in a
+// cache cell.
+bool Tft::print_glyph_cached(int hor, int ver, const Glyph &g, int y_adv,
+                             const Color fg, const Color bg)
+{
+    const GlyphCache::Key key{
+        g.data,  g.format,      g.w,     g.h,     g.x_off, g.y_off,
+        g.x_adv, int8_t(y_adv), rgb(fg), rgb(bg)};
+
+    bool hit = false;
+    const int cell = _glyph_cache->lookup(key, hit);
+    if (cell < 0)
+        return false;
+
+    trace_begin(Trace::Event::Glyph, uint32_t(g.x_adv * y_adv));
+
+    Pixel565 *pixels = _glyph_cache->pixels(cell);
+
+    if (!hit) {
+        // the cell's previous contents might not have been sent yet
+        while (!op_finished(_glyph_cache->op_seq(cell)))
+            tight_loop_contents();
+
+        GlyphRaster<Pixel565> raster(g, blend_lut(fg, bg));
+        for (int row = 0; row < y_adv; row++)
+            raster.row(pixels + row * g.x_adv);
+    }
+
+    op_copy(hor, ver, g.x_adv, y_adv, pixels);
+    _glyph_cache->op_seq(cell, _op_seq);
+
+    trace_end(Trace::Event::Glyph, uint32_t(g.x_adv * y_adv));
+
+    return true;
+}
+
+
+// Blend table for 'fg' on 'bg'. Text is usually printed in the same colors
+// many times in a row, so the last table is kept.
+const BlendLut<Pixel565> &Tft::blend_lut(const Color fg, const Color bg)
+{
+    const uint32_t fg_rgb = rgb(fg);
+    const uint32_t bg_rgb = rgb(bg);
+    if (!_blend_valid || fg_rgb != _blend_fg || bg_rgb != _blend_bg) {
+        _blend.set(bg, fg);
+        _blend_fg = fg_rgb;
+        _blend_bg = bg_rgb;
+        _blend_valid = true;
+    }
+    return _blend;
 }
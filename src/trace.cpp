@@ -0,0 +1,70 @@
+#include "trace.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+
+const char *Trace::name(Event event)
+{
+    switch (event) {
+        case Event::Enqueue:
+            return "enqueue";
+        case Event::Window:
+            return "window";
+        case Event::Dma:
+            return "dma";
+        case Event::Glyph:
+            return "glyph";
+        case Event::WaitIdle:
+            return "wait_idle";
+        default:
+            return "unknown";
+    }
+}
+
+
+// Chrome trace-event format, "JSON Object Format" flavor:
+//
+//   {"traceEvents":[
+//   {"name":"dma","ph":"B","ts":123,"pid":1,"tid":2,"args":{"arg":4800}},
+//   ...
+//   ]}
+//
+// Dma events go on their own track (tid 2) since the transfer runs in
+// parallel with whatever the cpu is doing. Everything else is on the cpu
+// track (tid 1). Events recorded from the dma interrupt handler (window
+// setup for queued ops) always nest inside whatever the main context was
+// doing, so begin/end pairs on the cpu track stay properly nested.
+void Trace::write_json(FILE *f) const
+{
+    const int cnt = _cnt;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+               "\"args\":{\"name\":\"cpu\"}},\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+               "\"args\":{\"name\":\"dma\"}}");
+
+    const uint32_t ts0 = (cnt > 0) ? _buf[0].ts : 0;
+
+    for (int i = 0; i < cnt; i++) {
+        const Record &r = _buf[i];
+        const char *ph = "i";
+        if (r.phase == Phase::Begin)
+            ph = "B";
+        else if (r.phase == Phase::End)
+            ph = "E";
+        const int tid = (r.event == Event::Dma) ? 2 : 1;
+        // unsigned subtraction handles clock wrap
+        const unsigned long ts = (unsigned long)(uint32_t)(r.ts - ts0);
+        fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lu,"
+                   "\"pid\":1,\"tid\":%d",
+                name(r.event), ph, ts, tid);
+        if (r.phase == Phase::Instant)
+            fprintf(f, ",\"s\":\"t\"");
+        fprintf(f, ",\"args\":{\"arg\":%lu}}", (unsigned long)r.arg);
+    }
+
+    fprintf(f, "\n],\"otherData\":{\"dropped\":%d}}\n", int(_dropped));
+}
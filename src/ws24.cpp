@@ -46,7 +46,7 @@ void Ws24::init()
         wr_cmd | VCOMCTL1,  0x33, 0x3f,
         wr_cmd | VCOMCTL2,  0x92,
         wr_cmd | PIXSET,    0x55,
-        wr_cmd | MADCTL,    madctl(),
+        wr_cmd | MADCTL,    madctl(get_rotation()),
         wr_cmd | FRMCTL,    0x00, 0x12,
         wr_cmd | DISPCTL,   0x0a, 0xa2,
         wr_cmd | SETTS,     0x02,
@@ -77,16 +77,16 @@ void Ws24::init()
 //   10 ML  vertical refresh order (always 0)
 //   08 RGB RGB-BGR order (always 1)
 //   04 MH  horizontal refresh order (always 0)
-uint8_t Ws24::madctl() const
+uint8_t Ws24::madctl(Rotation r) const
 {
-    if (get_rotation() == Rotation::portrait) {
+    if (r == Rotation::portrait) {
         return 0x08;
-    } else if (get_rotation() == Rotation::landscape) {
+    } else if (r == Rotation::landscape) {
         return 0xa8;
-    } else if (get_rotation() == Rotation::portrait2) {
+    } else if (r == Rotation::portrait2) {
         return 0xc8;
     } else {
-        assert(get_rotation() == Rotation::landscape2);
+        assert(r == Rotation::landscape2);
         return 0x68;
     }
 }
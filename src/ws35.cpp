@@ -50,7 +50,7 @@ void Ws35::init()
         wr_delay_ms | 120,
         wr_cmd | DISPON,
         wr_cmd | DFC, 0x00, 0x62,
-        wr_cmd | MADCTL, madctl(),
+        wr_cmd | MADCTL, madctl(get_rotation()),
         // clang-format on
     };
     const int cmds_len = sizeof(cmds) / sizeof(cmds[0]);
@@ -66,16 +66,16 @@ void Ws35::init()
 //   10 ML  vertical refresh order (always 0)
 //   08 RGB RGB-BGR order (always 1)
 //   04 MH  horizontal refresh order (always 0)
-uint8_t Ws35::madctl() const
+uint8_t Ws35::madctl(Rotation r) const
 {
-    if (get_rotation() == Rotation::portrait) {
+    if (r == Rotation::portrait) {
         return 0x48;
-    } else if (get_rotation() == Rotation::landscape) {
+    } else if (r == Rotation::landscape) {
         return 0xe8;
-    } else if (get_rotation() == Rotation::portrait2) {
+    } else if (r == Rotation::portrait2) {
         return 0x88;
     } else {
-        assert(get_rotation() == Rotation::landscape2);
+        assert(r == Rotation::landscape2);
         return 0x28;
     }
 }
@@ -3,6 +3,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 // pico
 #include "hardware/spi.h"
 #include "pico/rand.h"
@@ -15,11 +16,32 @@
 #include "sys_led.h"
 #include "util.h"
 // framebuffer
+#include "anim_player.h"
+#include "animation.h"
 #include "color.h"
+#include "fill_pattern.h"
 #include "font.h"
+#include "font_atlas.h"
+#include "font_pack.h"
+#include "font_symbol.h"
+#include "glyph_cache.h"
+#include "glyph_raster.h"
+#include "image_atlas.h"
+#include "image_patch.h"
+#include "indexed_image.h"
+#include "label.h"
+#include "mask_image.h"
+#include "numeric_field.h"
 #include "pixel_565.h"
 #include "pixel_image.h"
+#include "rle_image.h"
 #include "roboto.h"
+#include "roboto_kern.h"
+#include "roboto_packed.h"
+#include "seven_seg.h"
+#include "sprite_image.h"
+#include "sprite_layer.h"
+#include "trace.h"
 //
 #include "ws35_test_cfg.h"
 
@@ -34,6 +56,11 @@ static const Font &font = roboto_32; // height/10
 static constexpr int work_bytes = 128;
 static uint8_t work[work_bytes];
 
+// whole-string printing (Tft::line_buffer): a coverage row the screen's
+// width, and the rest a slot per character (see line_buffer_bytes)
+static constexpr int line_buf_bytes = 1536;
+alignas(4) static uint8_t line_buf[line_buf_bytes];
+
 // clang-format off
 static void rotations(Framebuffer &fb);
 static void corner_pixels(Framebuffer &fb);
@@ -65,6 +92,31 @@ namespace Font1 { static void run(Framebuffer &fb); };
 namespace Screen { static void run(Framebuffer &fb); };
 namespace ImgUpdate { static void run(Framebuffer &fb); }
 namespace ImgDigits { static void run(Framebuffer &fb); }
+namespace Trace1 { static void run(Framebuffer &fb); }
+namespace ImgRle { static void run(Framebuffer &fb); }
+namespace ImgIndexed { static void run(Framebuffer &fb); }
+namespace FontPack { static void run(Framebuffer &fb); }
+namespace FontNum { static void run(Framebuffer &fb); }
+namespace FontUtf8 { static void run(Framebuffer &fb); }
+namespace FontKern { static void run(Framebuffer &fb); }
+namespace GlyphCache1 { static void run(Framebuffer &fb); }
+namespace GlyphBench { static void run(Framebuffer &fb); }
+namespace PrintLine { static void run(Framebuffer &fb); }
+namespace Atlas { static void run(Framebuffer &fb); }
+namespace PrintScaled { static void run(Framebuffer &fb); }
+namespace SevenSegment { static void run(Framebuffer &fb); }
+namespace NumField { static void run(Framebuffer &fb); }
+namespace LabelUpdate { static void run(Framebuffer &fb); }
+namespace ImageView { static void run(Framebuffer &fb); }
+namespace NavAtlas { static void run(Framebuffer &fb); }
+namespace NavPatch { static void run(Framebuffer &fb); }
+namespace MaskIcon { static void run(Framebuffer &fb); }
+namespace Sprite { static void run(Framebuffer &fb); }
+namespace Orientation { static void run(Framebuffer &fb); }
+namespace PatternFill { static void run(Framebuffer &fb); }
+namespace ScaledImage { static void run(Framebuffer &fb); }
+namespace SpriteMove { static void run(Framebuffer &fb); }
+namespace AnimSpinner { static void run(Framebuffer &fb); }
 // clang-format on
 
 static struct {
@@ -101,6 +153,31 @@ static struct {
     {"Screen", Screen::run},
     {"ImgUpdate", ImgUpdate::run},
     {"ImgDigits", ImgDigits::run},
+    {"Trace1", Trace1::run},
+    {"ImgRle", ImgRle::run},
+    {"ImgIndexed", ImgIndexed::run},
+    {"FontPack", FontPack::run},
+    {"FontNum", FontNum::run},
+    {"FontUtf8", FontUtf8::run},
+    {"FontKern", FontKern::run},
+    {"GlyphCache1", GlyphCache1::run},
+    {"GlyphBench", GlyphBench::run},
+    {"PrintLine", PrintLine::run},
+    {"Atlas", Atlas::run},
+    {"PrintScaled", PrintScaled::run},
+    {"SevenSegment", SevenSegment::run},
+    {"NumField", NumField::run},
+    {"LabelUpdate", LabelUpdate::run},
+    {"ImageView", ImageView::run},
+    {"NavAtlas", NavAtlas::run},
+    {"NavPatch", NavPatch::run},
+    {"MaskIcon", MaskIcon::run},
+    {"Sprite", Sprite::run},
+    {"Orientation", Orientation::run},
+    {"PatternFill", PatternFill::run},
+    {"ScaledImage", ScaledImage::run},
+    {"SpriteMove", SpriteMove::run},
+    {"AnimSpinner", AnimSpinner::run},
 };
 static const int num_tests = sizeof(tests) / sizeof(tests[0]);
 
@@ -158,6 +235,8 @@ int main()
 
     fb.init();
 
+    fb.line_buffer(line_buf, line_buf_bytes);
+
     // Turning on the backlight here shows whatever happens to be in RAM
     // (previously displayed or random junk), so we turn it on after filling
     // the screen with something.
@@ -1428,3 +1507,1572 @@ static void run(Framebuffer &fb)
 }
 
 } // namespace ImgDigits
+
+
+namespace Trace1 {
+
+// Capture a timeline of drawing part of a screen and dump it as Chrome
+// trace-event JSON. Copy everything from the opening '{' to the closing '}'
+// into a file and load it in chrome://tracing or ui.perfetto.dev.
+
+static constexpr int rec_max = 512;
+static Trace::Record rec[rec_max];
+
+static void run(Framebuffer &fb)
+{
+    Trace trace(rec, rec_max, time_us_32);
+
+    fb.trace(&trace);
+
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::white());
+    fb.write(10, 10, &ImgString::img.hdr);
+    fb.print(10, 60, "Hello, world!", font, Color::black(), Color::white());
+    fb.write(fb.width() / 2, 120, 1234, ImgDigits::digit_img,
+             Framebuffer::HAlign::Center);
+    fb.wait_idle();
+
+    fb.trace(nullptr);
+
+    printf("Trace1: %d events (%d dropped)\n", trace.count(), trace.dropped());
+    printf("\n");
+    trace.write_json(stdout);
+    printf("\n");
+}
+
+} // namespace Trace1
+
+
+namespace ImgRle {
+
+// Compare run-length compressed copies of the Screen labels with the plain
+// images: flash used by each, and time to get each on the screen (including
+// wait_idle, so both are timed to completion).
+//
+// Decode throughput depends on the size of the work buffer given to the
+// constructor; each half of it is one dma transfer.
+
+#define RLE_MAKE(NAME, SRC)                                                \
+    static constexpr int NAME##_len = rle_len(SRC);                        \
+    static constexpr RleImage<SRC.hdr.wid, SRC.hdr.hgt, NAME##_len> NAME = \
+        rle_img<NAME##_len>(SRC);
+
+RLE_MAKE(home, Screen::Nav::home_inactive)
+RLE_MAKE(lights, Screen::Toots::lights_img)
+RLE_MAKE(stop, Screen::Toots::stop_img)
+RLE_MAKE(arrows, Screen::Slider::arrows_img)
+
+#undef RLE_MAKE
+
+static const struct {
+    const char *name;
+    const PixelImageHdr *raw;
+    int raw_bytes;
+    const RleImageHdr *rle;
+    int rle_bytes;
+} imgs[] = {
+    {"home", &Screen::Nav::home_inactive.hdr,
+     sizeof(Screen::Nav::home_inactive), &home.hdr, sizeof(home)},
+    {"lights", &Screen::Toots::lights_img.hdr,
+     sizeof(Screen::Toots::lights_img), &lights.hdr, sizeof(lights)},
+    {"stop", &Screen::Toots::stop_img.hdr, sizeof(Screen::Toots::stop_img),
+     &stop.hdr, sizeof(stop)},
+    {"arrows", &Screen::Slider::arrows_img.hdr,
+     sizeof(Screen::Slider::arrows_img), &arrows.hdr, sizeof(arrows)},
+};
+static const int imgs_max = sizeof(imgs) / sizeof(imgs[0]);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::white());
+    fb.wait_idle();
+
+    int ver = 0;
+    for (int i = 0; i < imgs_max; i++) {
+        assert(is_xip(imgs[i].raw) && is_xip(imgs[i].rle));
+
+        const int pix = imgs[i].raw->wid * imgs[i].raw->hgt;
+
+        uint32_t t0 = time_us_32();
+        fb.write(0, ver, imgs[i].raw);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        fb.write(0, ver + imgs[i].raw->hgt, imgs[i].rle);
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+
+        printf("ImgRle: %-7s %dw x %dh\n", imgs[i].name, imgs[i].raw->wid,
+               imgs[i].raw->hgt);
+        printf("  raw %6d bytes %6lu usec %5.2f Mpix/sec\n", imgs[i].raw_bytes,
+               t1 - t0, float(pix) / (t1 - t0));
+        printf("  rle %6d bytes %6lu usec %5.2f Mpix/sec (%.1fx smaller)\n",
+               imgs[i].rle_bytes, t2 - t1, float(pix) / (t2 - t1),
+               float(imgs[i].raw_bytes) / imgs[i].rle_bytes);
+
+        ver += imgs[i].raw->hgt * 2 + 4;
+    }
+}
+
+} // namespace ImgRle
+
+
+namespace ImgIndexed {
+
+// One 4-bit indexed label drawn in several color schemes by swapping the
+// palette. Compare flash used with the equivalent PixelImage.
+
+static constexpr Font font = Screen::Nav::font;
+static constexpr int wid = Screen::Nav::wid;
+static constexpr int hgt = Screen::Nav::hgt;
+
+static constexpr IndexedImage<4, wid, hgt> img =
+    label_idx<4, wid, hgt>("LOCO", font, 1);
+
+static constexpr Palette<4> normal =
+    blend_palette<4>(Color::white(), Color::black());
+static constexpr Palette<4> inverse =
+    blend_palette<4>(Color::black(), Color::white());
+static constexpr Palette<4> night =
+    blend_palette<4>(Color::black(), Color::red());
+static constexpr Palette<4> disabled =
+    blend_palette<4>(Color::gray(90), Color::gray(60));
+
+static void run(Framebuffer &fb)
+{
+    assert(is_xip(&img) && is_xip(&normal));
+
+    printf("ImgIndexed: %dw x %dh, %d bytes (PixelImage would be %d bytes)\n",
+           img.hdr.wid, img.hdr.hgt, sizeof(img),
+           sizeof(PixelImage<Pixel565, wid, hgt>));
+
+    const Palette<4> *pals[] = {&normal, &inverse, &night, &disabled};
+    int ver = 10;
+    for (const Palette<4> *pal : pals) {
+        uint32_t t0 = time_us_32();
+        fb.write(10, ver, &img.hdr, pal->colors);
+        uint32_t t1 = time_us_32();
+        printf("ImgIndexed: wrote in %lu usec\n", t1 - t0);
+        ver += hgt + 10;
+    }
+}
+
+} // namespace ImgIndexed
+
+
+namespace FontPack {
+
+// Flash used by each roboto size in each glyph format, and the time to
+// print the same string in each format.
+
+#define SIZE_MAKE(Z)                                          \
+    {Z, sizeof(roboto_##Z##_data), roboto_##Z##_4_len,       \
+     roboto_##Z##_rle4_len},
+
+static const struct {
+    int size;
+    int gray8;
+    int gray4;
+    int rle4;
+} sizes[] = {
+    // clang-format off
+    SIZE_MAKE(16) SIZE_MAKE(18) SIZE_MAKE(20) SIZE_MAKE(22) SIZE_MAKE(24)
+    SIZE_MAKE(26) SIZE_MAKE(28) SIZE_MAKE(30) SIZE_MAKE(32) SIZE_MAKE(34)
+    SIZE_MAKE(36) SIZE_MAKE(38) SIZE_MAKE(40) SIZE_MAKE(44) SIZE_MAKE(48)
+    // clang-format on
+};
+static const int sizes_max = sizeof(sizes) / sizeof(sizes[0]);
+
+#undef SIZE_MAKE
+
+static constexpr char msg[] = "Hello, world!";
+
+static void run(Framebuffer &fb)
+{
+    printf("FontPack: glyph data bytes\n");
+    printf("  size  gray8  gray4   rle4  saved\n");
+    int tot8 = 0;
+    int tot_rle4 = 0;
+    for (int i = 0; i < sizes_max; i++) {
+        printf("  %4d %6d %6d %6d %6d\n", sizes[i].size, sizes[i].gray8,
+               sizes[i].gray4, sizes[i].rle4, sizes[i].gray8 - sizes[i].rle4);
+        tot8 += sizes[i].gray8;
+        tot_rle4 += sizes[i].rle4;
+    }
+    printf("  total gray8 %d rle4 %d saved %d\n", tot8, tot_rle4,
+           tot8 - tot_rle4);
+
+    const struct {
+        const char *name;
+        const Font &font;
+    } fonts[] = {
+        {"gray8", roboto_24},
+        {"gray4", roboto_24_4},
+        {"rle4", roboto_24_rle4},
+    };
+
+    int ver = 10;
+    for (auto &f : fonts) {
+        uint32_t t0 = time_us_32();
+        fb.print(10, ver, msg, f.font, Color::white(), Color::black());
+        uint32_t t1 = time_us_32();
+        printf("FontPack: printed \"%s\" in %s in %lu usec\n", msg, f.name,
+               t1 - t0);
+        ver += f.font.height() + 10;
+    }
+}
+
+} // namespace FontPack
+
+
+namespace FontNum {
+
+// Print numbers with a number-only FontRange subset of roboto_48, and
+// compare flash used with the full font.
+
+static constexpr Color fg = Color::black();
+static constexpr Color bg = Color::white();
+
+static constexpr char time_str[] = "12:34";
+static constexpr int wid = roboto_48_num.width(time_str);
+static constexpr int hgt = roboto_48_num.height();
+static constexpr PixelImage<Pixel565, wid, hgt> time_img =
+    label_img<Pixel565, wid, hgt>(time_str, roboto_48_num, fg, bg);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("FontNum: roboto_48 %d bytes, roboto_48_num %d bytes\n",
+           sizeof(roboto_48) + sizeof(roboto_48_data),
+           sizeof(roboto_48_num) + sizeof(roboto_48_num_data));
+
+    const char *nums[] = {"0", "-1.5", "3.14159", "23:59"};
+    int ver = 10;
+    for (const char *num : nums) {
+        uint32_t t0 = time_us_32();
+        fb.print(10, ver, num, roboto_48_num, fg, bg);
+        uint32_t t1 = time_us_32();
+        printf("FontNum: printed \"%s\" in %lu usec\n", num, t1 - t0);
+        ver += hgt;
+    }
+
+    // not in the range, so not printed
+    fb.print(fb.width() / 2, 10, "ABC", roboto_48_num, fg, bg);
+
+    fb.write(fb.width() / 2, ver - hgt, &time_img.hdr);
+}
+
+} // namespace FontNum
+
+
+namespace FontUtf8 {
+
+// UTF-8 text with a FontSparse: roboto_24 plus a degree sign and arrows,
+// which roboto doesn't have.
+
+static constexpr Color fg = Color::black();
+static constexpr Color bg = Color::white();
+
+// sized and placed for roboto_24 (cap height 14, baseline at 19)
+static constexpr SymbolData<7, 7> deg = symbol_data<7, 7>(Symbol::Degree);
+static constexpr SymbolData<16, 10> arr_r =
+    symbol_data<16, 10>(Symbol::ArrowRight);
+static constexpr SymbolData<16, 10> arr_l =
+    symbol_data<16, 10>(Symbol::ArrowLeft);
+static constexpr SymbolData<10, 14> arr_u = symbol_data<10, 14>(Symbol::ArrowUp);
+static constexpr SymbolData<10, 14> arr_d =
+    symbol_data<10, 14>(Symbol::ArrowDown);
+
+static constexpr SparseGlyph extra[] = {
+    {0x00b0, symbol_glyph(deg, 1, 5, 9)},     // °
+    {0x2190, symbol_glyph(arr_l, 1, 9, 18)}, // ←
+    {0x2191, symbol_glyph(arr_u, 1, 5, 12)},  // ↑
+    {0x2192, symbol_glyph(arr_r, 1, 9, 18)},  // →
+    {0x2193, symbol_glyph(arr_d, 1, 5, 12)},  // ↓
+};
+static constexpr int extra_cnt = sizeof(extra) / sizeof(extra[0]);
+
+static constexpr FontSparseSize size =
+    font_sparse_size(roboto_24, extra, extra_cnt, GlyphFormat::Rle4);
+static constexpr FontSparseData<size.glyphs, size.pages, size.len> data =
+    font_sparse_data<size.glyphs, size.pages, size.len>(
+        roboto_24, extra, extra_cnt, GlyphFormat::Rle4);
+static constexpr FontSparse sparse =
+    font_sparse(roboto_24, data, GlyphFormat::Rle4);
+
+static constexpr char temp_str[] = "21.5°C ↑";
+static constexpr int wid = sparse.width(temp_str) + 8;
+static constexpr int hgt = sparse.height() + 8;
+static constexpr PixelImage<Pixel565, wid, hgt> temp_img =
+    label_img<Pixel565, wid, hgt>(temp_str, sparse, fg, bg, 2, fg);
+
+static_assert(sparse.printable(0x2192) && !sparse.printable(0x2194));
+static_assert(sparse.width("°") == 9);
+static_assert(roboto_24.width("°") == 0); // not in the ASCII font
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("FontUtf8: %d glyphs, %d pages, %d bytes\n", size.glyphs,
+           size.pages, sizeof(data) + sizeof(sparse));
+
+    const char *strs[] = {
+        "21.5°C ↑",
+        "← West  East →",
+        "Zug ↓ Gleis 3",
+        "bad \xff\xc3 utf-8", // invalid sequences are skipped
+    };
+    int ver = 10;
+    for (const char *s : strs) {
+        uint32_t t0 = time_us_32();
+        fb.print(10, ver, s, sparse, fg, bg);
+        uint32_t t1 = time_us_32();
+        printf("FontUtf8: \"%s\" width %d in %lu usec\n", s, sparse.width(s),
+               t1 - t0);
+        ver += sparse.height() + 4;
+    }
+
+    // same text in the ASCII font: non-ASCII characters are skipped
+    fb.print(10, ver, strs[0], roboto_24, fg, bg);
+    ver += sparse.height() + 4;
+
+    fb.write(10, ver, &temp_img.hdr);
+}
+
+} // namespace FontUtf8
+
+
+namespace FontKern {
+
+// Same strings with and without kerning, left/center/right aligned to the
+// red line, plus a kerned label image and the same string printed a
+// character at a time (no line buffer), which should look the same.
+
+static constexpr Color fg = Color::black();
+static constexpr Color bg = Color::white();
+
+static constexpr char label_str[] = "AVATAR";
+static constexpr int wid = roboto_24_kerned.width(label_str) + 8;
+static constexpr int hgt = roboto_24_kerned.height() + 8;
+static constexpr PixelImage<Pixel565, wid, hgt> label =
+    label_img<Pixel565, wid, hgt>(label_str, roboto_24_kerned, fg, bg, 2, fg);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("FontKern: roboto_24_kern %d pairs\n", roboto_24_kern.cnt);
+
+    const int mid = fb.width() / 2;
+    fb.line(mid, 0, mid, fb.height() - 1, Color::red());
+
+    const char *strs[] = {"AVATAR", "Tower, Yard.", "LTV Wave"};
+    int ver = 4;
+    for (const char *s : strs) {
+        printf("FontKern: \"%s\" width %d, kerned %d\n", s,
+               roboto_24.width(s), roboto_24_kerned.width(s));
+        fb.print(mid, ver, s, roboto_24, fg, bg, Framebuffer::HAlign::Right);
+        fb.print(mid, ver, s, roboto_24_kerned, fg, bg);
+        ver += roboto_24.height();
+        fb.print(mid, ver, s, roboto_24_kerned, fg, bg,
+                 Framebuffer::HAlign::Center);
+        ver += roboto_24.height();
+    }
+
+    fb.write(mid, ver, &label.hdr, Framebuffer::HAlign::Center);
+    ver += hgt;
+
+    fb.line_buffer(nullptr, 0);
+    fb.print(mid, ver + 4, label_str, roboto_24_kerned, fg, bg,
+             Framebuffer::HAlign::Center);
+    fb.line_buffer(line_buf, line_buf_bytes);
+}
+
+} // namespace FontKern
+
+
+namespace GlyphCache1 {
+
+// Print the same string without the glyph cache, with it empty, and with it
+// warm, then enough different characters to force evictions.
+
+static constexpr Color fg = Color::white();
+static constexpr Color bg = Color::blue();
+
+static constexpr int arena_bytes = 16 * 1024;
+alignas(4) static uint8_t arena[arena_bytes];
+
+static void print_counters(const GlyphCache &cache)
+{
+    printf("GlyphCache1: hits %lu, misses %lu, evictions %lu\n",
+           cache.hits(), cache.misses(), cache.evictions());
+}
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    GlyphCache cache(arena, arena_bytes, font.max_width() * font.height());
+    printf("GlyphCache1: %d cells of %d pixels\n", cache.cells(),
+           cache.cell_pixels());
+
+    const char *str = "12:34:56";
+    const char *pass_name[] = {"no cache", "cold", "warm"};
+    int ver = 10;
+    for (int pass = 0; pass < 3; pass++) {
+        if (pass == 1)
+            fb.glyph_cache(&cache);
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.print(10, ver, str, font, fg, bg);
+        uint32_t t1 = time_us_32();
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        printf("GlyphCache1: %s: print %lu usec, done after %lu usec\n",
+               pass_name[pass], t1 - t0, t2 - t0);
+        ver += font.height();
+    }
+    print_counters(cache);
+
+    // more different characters than there are cells
+    fb.print(10, ver, "ABCDEFGHIJKLM", font, fg, bg);
+    ver += font.height();
+    fb.print(10, ver, "NOPQRSTUVWXYZ", font, fg, bg);
+    ver += font.height();
+    fb.print(10, ver, str, font, fg, bg);
+    print_counters(cache);
+
+    // cache is going out of scope, so it must not be in use
+    fb.wait_idle();
+    fb.glyph_cache(nullptr);
+}
+
+} // namespace GlyphCache1
+
+
+namespace GlyphBench {
+
+// Character box rendering speed into ram (no spi), the way print used to do
+// it (Color::interpolate for every pixel) and with GlyphRaster.
+
+static constexpr Color fg = Color::black();
+static constexpr Color bg = Color::white();
+
+static Pixel565 cell[128 * 48]; // biggest box: x_adv is int8_t, roboto_48
+
+// per-pixel bounds test and interpolate, as print did before GlyphRaster
+template <typename FONT>
+static int render_old(const FONT &fnt, uint32_t c)
+{
+    const Glyph g = fnt.glyph(c);
+    GlyphReader gs = g.reader();
+    if (g.y_off < 0)
+        gs.skip(-g.y_off * g.w);
+    uint8_t gray_row[128];
+    int p = 0;
+    for (int row = 0; row < fnt.height(); row++) {
+        const bool g_row_in = row >= g.y_off && row < (g.y_off + g.h);
+        if (g_row_in)
+            gs.read(gray_row, g.w);
+        for (int col = 0; col < g.x_adv; col++) {
+            if (g_row_in && col >= g.x_off && col < (g.x_off + g.w))
+                cell[p++] = Color::interpolate(gray_row[col - g.x_off], bg, fg);
+            else
+                cell[p++] = bg;
+        }
+    }
+    return p;
+}
+
+template <typename FONT>
+static int render_new(const FONT &fnt, uint32_t c, const BlendLut<> &lut)
+{
+    const Glyph g = fnt.glyph(c);
+    GlyphRaster<> raster(g, lut);
+    for (int row = 0; row < fnt.height(); row++)
+        raster.row(cell + row * g.x_adv);
+    return g.x_adv * fnt.height();
+}
+
+template <typename FONT>
+static void bench(const char *name, const FONT &fnt)
+{
+    constexpr int reps = 4;
+
+    int pix = 0;
+    uint32_t t0 = time_us_32();
+    for (int r = 0; r < reps; r++)
+        for (uint32_t c = ' '; c <= '~'; c++)
+            pix += render_old(fnt, c);
+    uint32_t t_old = time_us_32() - t0;
+
+    t0 = time_us_32();
+    BlendLut<> lut(bg, fg);
+    uint32_t t_lut = time_us_32() - t0;
+
+    t0 = time_us_32();
+    for (int r = 0; r < reps; r++)
+        for (uint32_t c = ' '; c <= '~'; c++)
+            render_new(fnt, c, lut);
+    uint32_t t_new = time_us_32() - t0;
+
+    // pixels per usec is Mpix/sec
+    printf("GlyphBench: %s %d pix: interpolate %lu usec (%d.%02d Mpix/s), "
+           "raster %lu usec (%d.%02d Mpix/s), lut %lu usec\n",
+           name, pix, t_old, pix / int(t_old), (pix * 100 / int(t_old)) % 100,
+           t_new, pix / int(t_new), (pix * 100 / int(t_new)) % 100, t_lut);
+}
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    bench("font", font);
+    bench("roboto_24_rle4", roboto_24_rle4);
+    bench("roboto_48", roboto_48);
+
+    // and printing, which includes sending the pixels
+    const char *str = "The quick brown fox";
+    uint32_t t0 = time_us_32();
+    fb.print(10, 10, str, font, fg, bg);
+    fb.wait_idle();
+    uint32_t t1 = time_us_32();
+    printf("GlyphBench: print \"%s\" %lu usec\n", str, t1 - t0);
+}
+
+} // namespace GlyphBench
+
+
+namespace PrintLine {
+
+// Strings printed a character at a time (Framebuffer::print) and in one
+// window (Tft::print). Glyphs that extend outside their boxes ('j', 'f',
+// kerned pairs) are cropped by their neighbors in the first, but not the
+// second.
+
+static constexpr Color fg = Color::white();
+static constexpr Color bg = Color::black();
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    const char *strs[] = {"fjord jiffy", "AVATAR Tower", "0123456789"};
+    int ver = 4;
+    for (const char *s : strs) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.Framebuffer::print(10, ver, s, roboto_24_kerned, fg, bg);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        ver += roboto_24.height();
+        fb.print(10, ver, s, roboto_24_kerned, fg, bg);
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        ver += roboto_24.height() + 4;
+        printf("PrintLine: \"%s\": by char %lu usec, by line %lu usec\n", s,
+               t1 - t0, t2 - t1);
+    }
+}
+
+} // namespace PrintLine
+
+
+namespace Atlas {
+
+// Print with a FontAtlas (roboto_24 pre-rendered in fixed colors, in flash)
+// and with the font, and compare times.
+
+static constexpr Color fg = Color::yellow();
+static constexpr Color bg = Color::navy();
+
+static constexpr int first = ' ';
+static constexpr int last = '~';
+static constexpr int len = font_atlas_len(roboto_24, first, last);
+static constexpr FontAtlasData<first, last, len> atlas_data =
+    font_atlas_data<first, last, len>(roboto_24, fg, bg);
+static constexpr FontAtlas atlas = font_atlas(roboto_24, atlas_data);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("Atlas: %d bytes\n", sizeof(atlas_data));
+
+    const char *strs[] = {"Speed 45 km/h", "Next: Central", "12:34:56"};
+    int ver = 4;
+    for (const char *s : strs) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.print(10, ver, s, roboto_24, fg, bg);
+        uint32_t t1 = time_us_32();
+        ver += atlas.height();
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        fb.print(10, ver, s, atlas);
+        uint32_t t3 = time_us_32();
+        fb.wait_idle();
+        uint32_t t4 = time_us_32();
+        ver += atlas.height() + 4;
+        printf("Atlas: \"%s\": font %lu usec, atlas %lu usec (done %lu usec)\n",
+               s, t1 - t0, t3 - t2, t4 - t2);
+    }
+
+    // alignment matches the font's
+    const int mid = fb.width() / 2;
+    fb.print(mid, ver, "centered", atlas, Framebuffer::HAlign::Center);
+}
+
+} // namespace Atlas
+
+
+namespace PrintScaled {
+
+// Text at 1x to 4x the size of roboto_24, printed (character at a time and
+// in one window) and as a label image made at compile time.
+
+static constexpr Color fg = Color::white();
+static constexpr Color bg = Color::black();
+
+static constexpr int lbl_scale = 2;
+static constexpr int lbl_wid = roboto_24.width("km/h") * lbl_scale + 8;
+static constexpr int lbl_hgt = roboto_24.height() * lbl_scale;
+static constexpr PixelImage<Pixel565, lbl_wid, lbl_hgt> lbl =
+    label_img<Pixel565, lbl_wid, lbl_hgt>("km/h", roboto_24, fg, bg, 0,
+                                          Color::none(), lbl_scale);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    const char *s = "42";
+    int hor = 4;
+    int ver = 4;
+    int hgt = 0;
+    for (int scale = 1; scale <= 4; scale++) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.Framebuffer::print(hor, ver, s, roboto_24, fg, bg,
+                              Framebuffer::HAlign::Left, scale);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        fb.print(hor, ver, s, roboto_24, fg, bg, Framebuffer::HAlign::Left,
+                 scale);
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        printf("PrintScaled: %dx: by char %lu usec, by line %lu usec\n",
+               scale, t1 - t0, t2 - t1);
+        hor += roboto_24.width(s) * scale + 4;
+        hgt = roboto_24.height() * scale;
+    }
+
+    fb.write(4, ver + hgt + 4, &lbl.hdr);
+}
+
+} // namespace PrintScaled
+
+
+namespace SevenSegment {
+
+// Count with seven-segment numerals, drawn all at once and by changed
+// segments only, and compare times.
+
+static constexpr Color fg = Color::red();
+static constexpr Color bg = Color::black();
+static constexpr Color dim = Color::gray(10);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    const int hgt = fb.height() / 2;
+    const SevenSeg seg(hgt, hgt / 9, hgt / 12, true);
+    const int pitch = seg.width() + hgt / 12;
+    const int ndig = 4;
+    const int hor = (fb.width() - ndig * pitch) / 2;
+    const int ver = (fb.height() - hgt) / 2;
+
+    printf("SevenSegment: %d fills for 8\n", seg.fills(SevenSeg::seg_all));
+
+    uint8_t was[ndig];
+    for (int i = 0; i < ndig; i++)
+        was[i] = SevenSeg::seg_unknown;
+
+    uint32_t full_us = 0;
+    uint32_t delta_us = 0;
+    for (int n = 0; n < 200; n++) {
+        char str[ndig + 1];
+        snprintf(str, sizeof(str), "%0*d", ndig, n * 37 % 10000);
+
+        // all segments
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        for (int i = 0; i < ndig; i++)
+            seg.draw(fb, hor + i * pitch, ver, str[i], fg, dim);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        full_us += (t1 - t0);
+
+        // back to the previous value, then changed segments only
+        for (int i = 0; i < ndig; i++)
+            seg.draw(fb, hor + i * pitch, ver, was[i], SevenSeg::seg_unknown,
+                     fg, dim);
+        fb.wait_idle();
+        t0 = time_us_32();
+        for (int i = 0; i < ndig; i++) {
+            const uint8_t now = SevenSeg::segments(str[i]);
+            seg.draw(fb, hor + i * pitch, ver, now, was[i], fg, dim);
+            was[i] = now;
+        }
+        fb.wait_idle();
+        t1 = time_us_32();
+        delta_us += (t1 - t0);
+    }
+    printf("SevenSegment: all %lu usec, changed only %lu usec (per update)\n",
+           full_us / 200, delta_us / 200);
+}
+
+} // namespace SevenSegment
+
+
+namespace NumField {
+
+// A fixed-point speed readout updated at 50 Hz, re-sending only the cells
+// that change, and a clock showing ':' and zero padding.
+
+static constexpr Color fg = Color::white();
+static constexpr Color bg = Color::black();
+
+#define NF_IMG(NAME, STR)                                                     \
+    static constexpr PixelImage<Pixel565, font.width(STR), font.height()>     \
+        NAME = label_img<Pixel565, font.width(STR), font.height()>(STR, font, \
+                                                                   fg, bg);
+
+NF_IMG(nf_0, "0")
+NF_IMG(nf_1, "1")
+NF_IMG(nf_2, "2")
+NF_IMG(nf_3, "3")
+NF_IMG(nf_4, "4")
+NF_IMG(nf_5, "5")
+NF_IMG(nf_6, "6")
+NF_IMG(nf_7, "7")
+NF_IMG(nf_8, "8")
+NF_IMG(nf_9, "9")
+NF_IMG(nf_minus, "-")
+NF_IMG(nf_point, ".")
+NF_IMG(nf_colon, ":")
+
+#undef NF_IMG
+
+// space is as wide as a digit
+static constexpr PixelImage<Pixel565, font.width("0"), font.height()>
+    nf_space = label_img<Pixel565, font.width("0"), font.height()>(" ", font,
+                                                                   fg, bg);
+
+static const NumericField::Glyphs glyphs = {
+    {&nf_0.hdr, &nf_1.hdr, &nf_2.hdr, &nf_3.hdr, &nf_4.hdr, //
+     &nf_5.hdr, &nf_6.hdr, &nf_7.hdr, &nf_8.hdr, &nf_9.hdr},
+    &nf_minus.hdr,
+    &nf_point.hdr,
+    &nf_colon.hdr,
+    &nf_space.hdr,
+};
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    const int hor = fb.width() / 2;
+    NumericField speed(fb, hor, 10, glyphs, 6, Framebuffer::HAlign::Right,
+                       NumericField::Pad::Space, 1, bg);
+    NumericField clock(fb, hor, 20 + speed.height(), glyphs, 5,
+                       Framebuffer::HAlign::Right, NumericField::Pad::Zero, 0,
+                       bg);
+
+    // speed ramps up, then down through zero
+    const int updates = 250; // 5 seconds
+    int cells = 0;
+    uint32_t busy_us = 0;
+    int32_t v = 0;
+    int32_t dv = 3;
+    for (int n = 0; n < updates; n++) {
+        uint32_t t0 = time_us_32();
+        speed.show(v);
+        cells += speed.cells_sent();
+        char hhmm[6];
+        snprintf(hhmm, sizeof(hhmm), "%02d:%02d", (n / 60) % 24, n % 60);
+        clock.show(hhmm);
+        cells += clock.cells_sent();
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        busy_us += (t1 - t0);
+        v += dv;
+        if (v > 1200 || v < -300)
+            dv = -dv;
+        if ((t1 - t0) < 20000)
+            sleep_us(20000 - (t1 - t0));
+    }
+    printf("NumField: %d updates, %d cells sent, %lu usec per update\n",
+           updates, cells, busy_us / updates);
+}
+
+} // namespace NumField
+
+
+namespace LabelUpdate {
+
+// A counter in a 100x50 ram image (as in ImgUpdate), re-made each time
+// with label_img and with a Label that only re-renders and sends the
+// changed characters. After each update the Label's image must be the same
+// as label_img's.
+
+static constexpr Font font = roboto_32;
+static constexpr int wid = 100;
+static constexpr int hgt = 50;
+static constexpr Color fg = Color::lime();
+static constexpr Color bg = Color::gray(80);
+
+static PixelImage<Pixel565, wid, hgt> img1;
+static PixelImage<Pixel565, wid, hgt> img2;
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::black());
+
+    const int hor = 10;
+    const int ver1 = 10;
+    const int ver2 = ver1 + hgt + 10;
+
+    Label<Font> lbl(fb, hor, ver2, &img2.hdr, font, fg, bg, 1, fg);
+
+    const int updates = 100;
+    uint32_t img_us = 0;
+    uint32_t lbl_us = 0;
+    int cols = 0;
+    int diffs = 0;
+    for (int n = 1000; n < (1000 + updates); n++) {
+        char str[8];
+        snprintf(str, sizeof(str), "%d", n);
+
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        label_img<Pixel565>(&img1.hdr, str, font, fg, 1, fg, bg);
+        fb.write(hor, ver1, &img1.hdr);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        lbl.show(str);
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+
+        img_us += (t1 - t0);
+        lbl_us += (t2 - t1);
+        cols += lbl.cols_sent();
+
+        if (memcmp(img1.pixels, img2.pixels, sizeof(img1.pixels)) != 0) {
+            printf("LabelUpdate: \"%s\" differs from label_img\n", str);
+            diffs++;
+        }
+    }
+    printf("LabelUpdate: label_img %lu usec, Label %lu usec, %d of %d "
+           "columns per update\n",
+           img_us / updates, lbl_us / updates, cols / updates, wid);
+    assert(diffs == 0);
+}
+
+} // namespace LabelUpdate
+
+
+namespace ImageView {
+
+// Sprite-sheet animation and an image sliding on and off the screen, all
+// written as views of images in flash.
+
+static constexpr Color fg = Color::yellow();
+static constexpr Color bg = Color::navy();
+
+// eight 32x32 frames of a growing and shrinking disc, in a 4x2 sheet
+static constexpr int cell = 32;
+static constexpr int frames = 8;
+
+static constexpr PixelImage<Pixel565, 4 * cell, 2 * cell> make_sheet()
+{
+    PixelImage<Pixel565, 4 * cell, 2 * cell> img{};
+    for (int f = 0; f < frames; f++) {
+        const int r = 4 + 3 * ((f < 4) ? f : (7 - f)); // 4..13
+        const int x0 = (f % 4) * cell;
+        const int y0 = (f / 4) * cell;
+        for (int y = 0; y < cell; y++) {
+            for (int x = 0; x < cell; x++) {
+                const int dx = 2 * x + 1 - cell; // from center, half pixels
+                const int dy = 2 * y + 1 - cell;
+                const bool in = (dx * dx + dy * dy) <= (4 * r * r);
+                img.pixels[(y0 + y) * img.hdr.wid + x0 + x] = in ? fg : bg;
+            }
+        }
+    }
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, 4 * cell, 2 * cell> sheet =
+    make_sheet();
+
+static constexpr int lbl_wid = 120;
+static constexpr int lbl_hgt = 40;
+static constexpr PixelImage<Pixel565, lbl_wid, lbl_hgt> lbl =
+    label_img<Pixel565, lbl_wid, lbl_hgt>("Sliding", font, fg, bg, 2, fg);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    // the whole sheet, then each frame of it
+    fb.write(10, 10, &sheet.hdr);
+    for (int i = 0; i < 3 * frames; i++) {
+        const PixelImageView v = image_cell(&sheet.hdr, cell, cell, i % frames);
+        fb.write(10 + 4 * cell + 20, 10, v);
+        sleep_ms(80);
+    }
+
+    // slide the label in from the left edge and out the right
+    const int ver = fb.height() / 2;
+    uint32_t us = 0;
+    int steps = 0;
+    for (int hor = -lbl_wid; hor <= fb.width(); hor += 4) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.write(hor, ver, &lbl.hdr);
+        uint32_t t1 = time_us_32();
+        us += (t1 - t0);
+        steps++;
+        sleep_ms(10);
+        if (hor >= 0)
+            fb.fill_rect(hor, ver, 4, lbl_hgt, bg); // trailing edge
+    }
+    printf("ImageView: %d writes, %lu usec each to queue\n", steps,
+           us / steps);
+}
+
+} // namespace ImageView
+
+
+namespace NavAtlas {
+
+// The navigation bar labels from Screen, active and inactive, packed in one
+// ImageAtlas instead of ten separate images.
+
+static constexpr Font font = roboto_20;
+static constexpr int hgt = font.y_adv + 2;
+static constexpr int wid = fb_width / 5;
+static constexpr Color bg = Color::white();
+static constexpr Color fg = Color::black();
+
+// handle for each label
+enum : int {
+    HomeActive, HomeInactive, LocoActive, LocoInactive, FuncActive,
+    FuncInactive, ProgActive, ProgInactive, MoreActive, MoreInactive,
+    LabelCnt
+};
+
+static constexpr AtlasLabel labels[LabelCnt] = {
+    {"HOME", wid, hgt, fg, bg}, {"HOME", wid, hgt, fg, bg, 1, fg},
+    {"LOCO", wid, hgt, fg, bg}, {"LOCO", wid, hgt, fg, bg, 1, fg},
+    {"FUNC", wid, hgt, fg, bg}, {"FUNC", wid, hgt, fg, bg, 1, fg},
+    {"PROG", wid, hgt, fg, bg}, {"PROG", wid, hgt, fg, bg, 1, fg},
+    {"MORE", wid, hgt, fg, bg}, {"MORE", wid, hgt, fg, bg, 1, fg},
+};
+
+static constexpr int atlas_wid = 5 * wid;
+static constexpr int atlas_hgt =
+    image_atlas_height(labels, LabelCnt, atlas_wid);
+static constexpr ImageAtlas<LabelCnt, atlas_wid, atlas_hgt> atlas =
+    image_atlas<LabelCnt, atlas_wid, atlas_hgt>(labels, font);
+
+static void draw(Framebuffer &fb, int active)
+{
+    for (int i = 0; i < 5; i++) {
+        const int lbl = 2 * i + ((i == active) ? 0 : 1);
+        fb.write(i * wid, 0, atlas.view(lbl));
+    }
+}
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("NavAtlas: %d bytes in one atlas (%d bytes as ten images)\n",
+           sizeof(atlas), 10 * sizeof(PixelImage<Pixel565, wid, hgt>));
+
+    for (int n = 0; n < 10; n++) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        draw(fb, n % 5);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        printf("NavAtlas: draw %lu usec\n", t1 - t0);
+        sleep_ms(500);
+    }
+}
+
+} // namespace NavAtlas
+
+
+namespace NavPatch {
+
+// Switching the active Screen::Nav button with image patches: only the
+// pixels that differ between a button's active and inactive images (the
+// border) are sent.
+
+using namespace Screen::Nav;
+
+#define PATCH_MAKE(name, from, to)                                             \
+    static constexpr int name##_len = image_patch_len(from, to);               \
+    static constexpr ImagePatch<wid, hgt, name##_len> name =                   \
+        image_patch<name##_len>(from, to);
+
+PATCH_MAKE(home_on, home_inactive, home_active)
+PATCH_MAKE(home_off, home_active, home_inactive)
+PATCH_MAKE(loco_on, loco_inactive, loco_active)
+PATCH_MAKE(loco_off, loco_active, loco_inactive)
+PATCH_MAKE(func_on, func_inactive, func_active)
+PATCH_MAKE(func_off, func_active, func_inactive)
+PATCH_MAKE(prog_on, prog_inactive, prog_active)
+PATCH_MAKE(prog_off, prog_active, prog_inactive)
+PATCH_MAKE(more_on, more_inactive, more_active)
+PATCH_MAKE(more_off, more_active, more_inactive)
+
+#undef PATCH_MAKE
+
+static const ImagePatchHdr *const on[5] = {
+    &home_on.hdr, &loco_on.hdr, &func_on.hdr, &prog_on.hdr, &more_on.hdr,
+};
+
+static const ImagePatchHdr *const off[5] = {
+    &home_off.hdr, &loco_off.hdr, &func_off.hdr, &prog_off.hdr, &more_off.hdr,
+};
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Screen::bg);
+
+    printf("NavPatch: %d bytes to switch a button (%d bytes as an image)\n",
+           int(home_on.hdr.len * sizeof(uint16_t)),
+           int(wid * hgt * sizeof(Pixel565)));
+
+    Screen::Nav::draw(fb, 0);
+    int active = 0;
+    for (int n = 1; n <= 10; n++) {
+        const int next = n % 5;
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.write_patch(active * wid, 0, off[active]);
+        fb.write_patch(next * wid, 0, on[next]);
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        Screen::Nav::draw(fb, next);
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        printf("NavPatch: patch %lu usec, redraw %lu usec\n", t1 - t0,
+               t2 - t1);
+        active = next;
+        sleep_ms(500);
+    }
+}
+
+} // namespace NavPatch
+
+
+namespace MaskIcon {
+
+// One alpha-mask icon drawn in several colors. A 565 image would need a
+// copy in flash for each color.
+
+static constexpr SymbolData<32, 20> arrow_cov =
+    symbol_data<32, 20>(Symbol::ArrowRight);
+static constexpr MaskImage<8, 32, 20> arrow_a8 = mask_img<8>(arrow_cov);
+static constexpr MaskImage<4, 32, 20> arrow_a4 = mask_img<4>(arrow_cov);
+
+// a character as an icon
+static constexpr int at_hgt = font.height();
+static constexpr MaskImage<4, at_hgt, at_hgt> at =
+    mask_char<4, at_hgt, at_hgt>('@', font);
+
+static constexpr Color colors[] = {
+    Color::red(),  Color::green(),  Color::blue(),
+    Color::white(), Color::yellow(), Color::cyan(),
+};
+static constexpr int num_colors = sizeof(colors) / sizeof(colors[0]);
+
+static void run(Framebuffer &fb)
+{
+    const Color bg = Color::black();
+    fb.fill_rect(0, 0, fb.width(), fb.height(), bg);
+
+    printf("MaskIcon: A8 %d bytes, A4 %d bytes, 565 %d bytes per color\n",
+           sizeof(arrow_a8), sizeof(arrow_a4),
+           sizeof(PixelImage<Pixel565, 32, 20>));
+
+    for (int i = 0; i < num_colors; i++) {
+        const int hor = 10 + i * 40;
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.write_mask(hor, 10, &arrow_a8.hdr, colors[i], bg);
+        uint32_t t1 = time_us_32();
+        fb.write_mask(hor, 40, &arrow_a4.hdr, colors[i], bg);
+        uint32_t t2 = time_us_32();
+        fb.write_mask(hor, 70, &at.hdr, colors[i], bg);
+        printf("MaskIcon: A8 %lu usec, A4 %lu usec\n", t1 - t0, t2 - t1);
+    }
+
+    // same icon, colors changing in place
+    for (int n = 0; n < 20; n++) {
+        fb.write_mask(10, 110, &arrow_a4.hdr, colors[n % num_colors], bg);
+        sleep_ms(250);
+    }
+}
+
+} // namespace MaskIcon
+
+
+namespace Sprite {
+
+// A color-keyed loco sprite over a track diagram, compared to writing the
+// whole image (which paints its background over the diagram).
+
+static constexpr Color key = Color::magenta();
+static constexpr int wid = 48;
+static constexpr int hgt = 32;
+
+// loco silhouette: boiler, cab, chimney, wheels
+static constexpr PixelImage<Pixel565, wid, hgt> loco_src()
+{
+    PixelImage<Pixel565, wid, hgt> img{};
+    for (int y = 0; y < hgt; y++) {
+        for (int x = 0; x < wid; x++) {
+            Pixel565 c = key;
+            if (y >= 12 && y < 24 && x >= 4 && x < 36)
+                c = Color::green(); // boiler
+            if (y >= 2 && y < 24 && x >= 32 && x < 46)
+                c = Color::dark_green(); // cab
+            if (y >= 4 && y < 12 && x >= 8 && x < 14)
+                c = Color::black(); // chimney
+            for (int w = 0; w < 3; w++) {
+                const int dx = x - (10 + w * 14);
+                const int dy = y - 26;
+                if ((dx * dx + dy * dy) <= 25)
+                    c = Color::red(); // wheel
+            }
+            img.pixels[y * wid + x] = c;
+        }
+    }
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, wid, hgt> loco = loco_src();
+static constexpr int loco_len = sprite_len(loco, key);
+static constexpr SpriteImage<wid, hgt, loco_len> loco_spr =
+    sprite_img<loco_len>(loco, key);
+
+static void track(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::gray());
+    for (int v = 20; v < fb.height(); v += 40) {
+        fb.fill_rect(0, v, fb.width(), 3, Color::white());
+        for (int h = 0; h < fb.width(); h += 16)
+            fb.fill_rect(h, v - 4, 3, 11, Color::brown());
+    }
+}
+
+static void run(Framebuffer &fb)
+{
+    track(fb);
+
+    int opaque = 0;
+    for (int i = 0; i < wid * hgt; i++)
+        if (loco.pixels[i].value() != Pixel565(key).value())
+            opaque++;
+    printf("Sprite: %d rects, %d of %d pixels sent, %d bytes\n",
+           loco_spr.hdr.rects, opaque, wid * hgt, sizeof(loco_spr));
+
+    // each row: sprites, then whole images for comparison
+    uint32_t spr_us = 0;
+    uint32_t img_us = 0;
+    int n = 0;
+    for (int v = 0; (v + hgt) <= fb.height(); v += 2 * 40) {
+        for (int h = 0; (h + wid) <= fb.width(); h += wid + 8) {
+            fb.wait_idle();
+            uint32_t t0 = time_us_32();
+            fb.write_sprite(h, v, &loco_spr.hdr);
+            fb.wait_idle();
+            uint32_t t1 = time_us_32();
+            if ((v + 40 + hgt) <= fb.height())
+                fb.write(h, v + 40, (const PixelImageHdr *)&loco);
+            fb.wait_idle();
+            uint32_t t2 = time_us_32();
+            spr_us += (t1 - t0);
+            img_us += (t2 - t1);
+            n++;
+        }
+    }
+    printf("Sprite: sprite %lu usec, image %lu usec (average of %d)\n",
+           spr_us / n, img_us / n, n);
+
+    sleep_ms(2000);
+}
+
+} // namespace Sprite
+
+
+namespace Orientation {
+
+// An image and a string drawn in each orientation, by having the display
+// controller remap its addressing for the op. The pixels are sent as they
+// are; nothing is rearranged in memory.
+
+using Orient = Framebuffer::Orient;
+
+static constexpr Color fg = Color::black();
+static constexpr Color bg = Color::white();
+static constexpr char arrow_txt[] = "F>";
+static constexpr int wid = 48;
+static constexpr int hgt = 32;
+static constexpr PixelImage<Pixel565, wid, hgt> arrow =
+    label_img<Pixel565, wid, hgt>(arrow_txt, roboto_20, fg, 1, fg, bg);
+
+static const char *const names[] = {
+    "None", "Cw90", "Cw180", "Cw270",
+    "Mirror", "MirrorCw90", "MirrorCw180", "MirrorCw270",
+};
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::gray());
+
+    // images, each in a 'wid' x 'wid' cell
+    for (int o = 0; o < 8; o++) {
+        const int hor = 4 + (o % 4) * (wid + 4);
+        const int ver = 4 + (o / 4) * (wid + 4);
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.write(hor, ver, (const PixelImageHdr *)&arrow, Orient(o));
+        fb.wait_idle();
+        uint32_t t1 = time_us_32();
+        printf("Orientation: %-11s %lu usec\n", names[o], t1 - t0);
+    }
+
+    // vertical text, both ways, with an unrotated fill after each to show
+    // the orientation is back to normal
+    const int ver = 2 * (wid + 4) + 4;
+    fb.print(4, ver, "Down the side", roboto_20, fg, bg, Orient::Cw90);
+    fb.fill_rect(40, ver, 20, 20, Color::red());
+    fb.print(70, ver, "Up the side", roboto_20, fg, bg, Orient::Cw270);
+    fb.fill_rect(106, ver, 20, 20, Color::green());
+    fb.print(136, ver, "Upside down", roboto_20, fg, bg, Orient::Cw180);
+
+    // a character at a time: without a line buffer, and running off the
+    // bottom of the screen (the characters that don't fit are skipped)
+    const int h = fb.width() - 2 * roboto_20.height();
+    fb.line_buffer(nullptr, 0);
+    fb.print(h, 4, "No line buffer", roboto_20, fg, bg, Orient::MirrorCw90);
+    fb.line_buffer(line_buf, line_buf_bytes);
+    fb.print(h + roboto_20.height(), fb.height() / 2,
+             "This runs off the bottom edge", roboto_20, fg, bg,
+             Orient::Cw90);
+
+    sleep_ms(3000);
+}
+
+} // namespace Orientation
+
+
+namespace PatternFill {
+
+// Hatching, stripes, a checkerboard, and a texture, each filled by dma
+// like a solid color, timed against a solid fill of the same size.
+
+static constexpr FillPattern<8, 8> hatch =
+    pattern_hatch<8>(Color::light_gray(), Color::dark_gray(), 2);
+static constexpr FillPattern<1, 6> stripes =
+    pattern_stripes<6>(Color::navy(), Color::blue(), 3);
+static constexpr FillPattern<16, 16> checker =
+    pattern_checker<16, 16>(Color::white(), Color::black());
+
+// texture: bricks, two rows, offset by half a brick
+static constexpr PixelImage<Pixel565, 16, 8> brick_src()
+{
+    PixelImage<Pixel565, 16, 8> img{};
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 16; x++) {
+            const bool mortar = (y % 4) == 3 || ((x + (y / 4) * 8) % 16) == 15;
+            img.pixels[y * 16 + x] =
+                mortar ? Color::light_gray() : Color::fire_brick();
+        }
+    }
+    return img;
+}
+
+static constexpr FillPattern<16, 8> brick = pattern_img(brick_src());
+
+static void run(Framebuffer &fb)
+{
+    const int wid = fb.width() / 2;
+    const int hgt = fb.height() / 2;
+
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::black());
+
+    fb.wait_idle();
+    uint32_t t0 = time_us_32();
+    fb.fill_rect(0, 0, wid, hgt, Color::dark_gray());
+    fb.wait_idle();
+    uint32_t t1 = time_us_32();
+    printf("PatternFill: solid %lu usec\n", t1 - t0);
+
+    struct {
+        const char *name;
+        const Pixel565 *pixels;
+        int pat_wid, pat_hgt;
+    } pats[] = {
+        {"hatch", hatch.pixels, 8, 8},
+        {"stripes", stripes.pixels, 1, 6},
+        {"checker", checker.pixels, 16, 16},
+        {"brick", brick.pixels, 16, 8},
+    };
+
+    for (int i = 0; i < 4; i++) {
+        const int hor = (i % 2) * wid;
+        const int ver = (i / 2) * hgt;
+        fb.wait_idle();
+        t0 = time_us_32();
+        fb.fill_pattern(hor, ver, wid, hgt, pats[i].pixels, pats[i].pat_wid,
+                        pats[i].pat_hgt);
+        t1 = time_us_32();
+        fb.wait_idle();
+        uint32_t t2 = time_us_32();
+        printf("PatternFill: %-7s %lu usec to queue, %lu usec total\n",
+               pats[i].name, t1 - t0, t2 - t0);
+    }
+
+    // a disabled button: hatching over a button's area, which lines up
+    // with the hatching around it since the tile is anchored to the screen
+    fb.fill_pattern(20, 20, 100, 40, hatch);
+    fb.fill_pattern(40, 30, 60, 20, hatch);
+
+    sleep_ms(3000);
+}
+
+} // namespace PatternFill
+
+
+namespace ScaledImage {
+
+// One small icon written at several sizes. The flash image is 8x8; each
+// size is made as it's written. Scaled rows that fit half the working
+// buffer are expanded once and re-sent; wider ones (the last few here, with
+// the tests' small working buffer) are expanded for each copy.
+
+static constexpr const char *face[8] = {
+    "..####..", //
+    ".#....#.", //
+    "#.#..#.#", //
+    "#......#", //
+    "#.#..#.#", //
+    "#..##..#", //
+    ".#....#.", //
+    "..####..", //
+};
+
+static constexpr PixelImage<Pixel565, 8, 8> face_src()
+{
+    PixelImage<Pixel565, 8, 8> img{};
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            img.pixels[y * 8 + x] =
+                face[y][x] == '#' ? Color::black() : Color::yellow();
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, 8, 8> img = face_src();
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::gray(80));
+
+    int hor = 4;
+    for (int s = 1; s <= 8; s++) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        fb.write_scaled(hor, 4, &img.hdr, s, s);
+        uint32_t t1 = time_us_32();
+        printf("ScaledImage: %dx %lu usec\n", s, t1 - t0);
+        hor += 8 * s + 4;
+        if ((hor + 8 * (s + 1)) > fb.width())
+            break;
+    }
+
+    // stretched one way only
+    fb.write_scaled(4, 80, &img.hdr, 1, 4);
+    fb.write_scaled(20, 80, &img.hdr, 4, 1);
+    fb.write_scaled(60, 80, &img.hdr, 2, 6);
+}
+
+} // namespace ScaledImage
+
+
+namespace SpriteMove {
+
+// A color-keyed loco (the one from the Sprite test) running along a track
+// on a map image, and an opaque cursor wandering over both, each move
+// restoring what was under it from the map.
+
+static constexpr int map_wid = 160;
+static constexpr int map_hgt = 96;
+
+static constexpr PixelImage<Pixel565, map_wid, map_hgt> map_src()
+{
+    PixelImage<Pixel565, map_wid, map_hgt> img{};
+    for (int y = 0; y < map_hgt; y++) {
+        for (int x = 0; x < map_wid; x++) {
+            Pixel565 c = Color::dark_olive_green();
+            if (y >= 70 && y < 73)
+                c = Color::white(); // rail
+            else if (y >= 66 && y < 77 && (x % 16) < 3)
+                c = Color::brown(); // sleeper
+            else if (((x / 8) + (y / 8)) % 7 == 0)
+                c = Color::olive_drab(); // fields
+            img.pixels[y * map_wid + x] = c;
+        }
+    }
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, map_wid, map_hgt> map = map_src();
+
+static constexpr PixelImage<Pixel565, 12, 12> cursor_src()
+{
+    PixelImage<Pixel565, 12, 12> img{};
+    for (int y = 0; y < 12; y++)
+        for (int x = 0; x < 12; x++)
+            img.pixels[y * 12 + x] = (x == 5 || x == 6 || y == 5 || y == 6)
+                                         ? Color::yellow()
+                                         : Color::black();
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, 12, 12> cursor = cursor_src();
+
+static void run(Framebuffer &fb)
+{
+    const int map_hor = (fb.width() - map_wid) / 2;
+    const int map_ver = 40;
+
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::black());
+    fb.write(map_hor, map_ver, &map.hdr);
+
+    SpriteLayer layer(fb, &map.hdr, map_hor, map_ver, Color::black());
+    const int loco = layer.add(&Sprite::loco_spr.hdr);
+    const int curs = layer.add(&cursor.hdr);
+
+    const int loco_ver = map_ver + 71 - 26; // wheels on the rail
+    int loco_sent = 0;
+    int curs_sent = 0;
+    uint32_t us = 0;
+    int n = 0;
+    for (int h = map_hor - Sprite::wid; h <= (map_hor + map_wid); h += 2) {
+        fb.wait_idle();
+        uint32_t t0 = time_us_32();
+        layer.move(loco, h, loco_ver);
+        loco_sent += layer.pixels_sent();
+        layer.move(curs, map_hor + 20 + n, map_ver + 10 + n / 2);
+        curs_sent += layer.pixels_sent();
+        fb.wait_idle();
+        us += (time_us_32() - t0);
+        n++;
+        sleep_ms(20);
+    }
+    printf("SpriteMove: loco %d, cursor %d pixels per move, %lu usec "
+           "(average of %d)\n",
+           loco_sent / n, curs_sent / n, us / n, n);
+
+    layer.hide(loco);
+    layer.hide(curs);
+}
+
+} // namespace SpriteMove
+
+
+namespace AnimSpinner {
+
+// A "connecting" spinner played from a delta-encoded animation while the
+// loop keeps counting, first at a rate spi keeps up with, then at one it
+// doesn't (dropped frames).
+
+static constexpr int wid = 32;
+static constexpr int hgt = 32;
+
+// top left of each 6x6 dot, clockwise from the top
+static constexpr int dots[8][2] = {
+    {13, 2}, {21, 5}, {24, 13}, {21, 21}, {13, 24}, {5, 21}, {2, 13}, {5, 5},
+};
+
+// frame 'f': dot 'f' lit, the one before it fading
+static constexpr PixelImage<Pixel565, wid, hgt> frame(int f)
+{
+    PixelImage<Pixel565, wid, hgt> img{};
+    for (int y = 0; y < hgt; y++) {
+        for (int x = 0; x < wid; x++) {
+            Pixel565 c = Color::black();
+            for (int d = 0; d < 8; d++) {
+                if (x < dots[d][0] || x >= (dots[d][0] + 6) || //
+                    y < dots[d][1] || y >= (dots[d][1] + 6))
+                    continue;
+                if (d == f)
+                    c = Color::white();
+                else if (d == (f + 7) % 8)
+                    c = Color::gray();
+                else
+                    c = Color::dark_gray();
+            }
+            img.pixels[y * wid + x] = c;
+        }
+    }
+    return img;
+}
+
+static constexpr PixelImage<Pixel565, wid, hgt> frames[] = {
+    frame(0), frame(1), frame(2), frame(3),
+    frame(4), frame(5), frame(6), frame(7),
+};
+static constexpr int num_frames = sizeof(frames) / sizeof(frames[0]);
+static constexpr int len = anim_len(frames, num_frames);
+static constexpr Animation<wid, hgt, len> spinner =
+    anim_img<len>(frames, num_frames);
+
+static void run(Framebuffer &fb)
+{
+    fb.fill_rect(0, 0, fb.width(), fb.height(), Color::black());
+
+    printf("AnimSpinner: %d frames, %d bytes (%d bytes as images)\n",
+           num_frames, sizeof(spinner), sizeof(frames));
+
+    const int fps[] = {15, 2000};
+    for (int i = 0; i < 2; i++) {
+        AnimPlayer player(fb, 20 + i * 60, 20, &spinner.hdr, fps[i]);
+        player.start();
+        int loops = 0;
+        const uint32_t t0 = time_us_32();
+        while ((time_us_32() - t0) < 2'000'000) {
+            player.poll();
+            loops++;
+        }
+        fb.wait_idle();
+        printf("AnimSpinner: %d fps: %d shown, %d dropped, %d loops\n",
+               fps[i], player.frames_shown(), player.frames_dropped(), loops);
+    }
+
+    // once through, then stopped on the last frame
+    AnimPlayer once(fb, 140, 20, &spinner.hdr, 8, false);
+    once.start();
+    while (once.poll())
+        tight_loop_contents();
+}
+
+} // namespace AnimSpinner